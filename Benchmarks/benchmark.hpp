@@ -0,0 +1,126 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <algorithm>
+
+#include "json.hpp"
+
+// Shared helpers for the headless benchmark executables. Every executable prints a short table to
+// stderr and writes its results as JSON (stdout, or the file given with --out <path>) so runs can be
+// diffed and tracked over time.
+
+class BenchmarkReport
+{
+public:
+  explicit BenchmarkReport(const std::string &suite)
+  {
+    report["suite"] = suite;
+#ifdef NDEBUG
+    report["build"] = "release";
+#else
+    report["build"] = "debug";
+#endif
+#if defined(__clang__)
+    report["compiler"] = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    report["compiler"] = std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    report["compiler"] = "msvc " + std::to_string(_MSC_VER);
+#endif
+    report["results"] = nlohmann::json::array();
+  }
+
+  // items is whatever the benchmark counts (entities, samples, voxels, bytes), seconds is the time for all of them
+  void Add(const std::string &name, const nlohmann::json &params, uint64_t items, double seconds, const nlohmann::json &extra = nlohmann::json::object())
+  {
+    nlohmann::json result;
+    result["name"] = name;
+    result["params"] = params;
+    result["items"] = items;
+    result["seconds"] = seconds;
+    result["items_per_second"] = seconds > 0.0 ? items / seconds : 0.0;
+    result["ns_per_item"] = items > 0 ? seconds * 1e9 / items : 0.0;
+    for (auto &[key, value] : extra.items())
+      result[key] = value;
+
+    std::cerr << name << " " << params.dump() << ": " << result["ns_per_item"].get<double>() << " ns/item, "
+              << result["items_per_second"].get<double>() << " items/s\n";
+
+    report["results"].push_back(result);
+  }
+
+  void Write(int argc, char **argv) const
+  {
+    std::string path;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+      if (std::strcmp(argv[i], "--out") == 0)
+        path = argv[i + 1];
+    }
+
+    if (path.empty())
+    {
+      std::cout << report.dump(2) << std::endl;
+      return;
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+      std::cerr << "Failed to open benchmark output! File: " << path << std::endl;
+      return;
+    }
+    file << report.dump(2) << std::endl;
+  }
+
+private:
+  nlohmann::json report;
+};
+
+template <typename Fn>
+double MeasureSeconds(Fn &&fn)
+{
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// runs setup then the measured body repetitions times and keeps the fastest body, setup is not timed
+template <typename Setup, typename Fn>
+double BestOf(int repetitions, Setup &&setup, Fn &&fn)
+{
+  double best = 1e30;
+  for (int i = 0; i < repetitions; i++)
+  {
+    setup();
+    best = std::min(best, MeasureSeconds(fn));
+  }
+  return best;
+}
+
+// keeps the optimizer from discarding results that are otherwise unused
+template <typename T>
+void DoNotOptimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const T *sink;
+  sink = &value;
+#endif
+}
+
+inline bool HasFlag(int argc, char **argv, const char *flag)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::strcmp(argv[i], flag) == 0)
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,84 @@
+#include "benchmark.hpp"
+#include "biomeIndex.hpp"
+
+#include <random>
+#include <vector>
+
+// Nearest biome lookups through the BiomeIndex lookup grid against the linear scan it replaced, for
+// 4 to 256 biomes. Also checks both pick the same biome for every query.
+// Usage: BiomeBenchmark [--quick] [--out results.json]
+// Exits with 1 if the index and the linear scan ever disagree.
+
+static std::vector<BiomeIndex::Point> RandomPoints(std::mt19937 &rng, size_t count)
+{
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  std::vector<BiomeIndex::Point> points(count);
+  for (auto &point : points)
+    for (float &value : point)
+      value = dist(rng);
+  return points;
+}
+
+int main(int argc, char **argv)
+{
+  const size_t queryCount = HasFlag(argc, argv, "--quick") ? 100000 : 1000000;
+  const int repetitions = 3;
+
+  std::mt19937 rng(1234);
+  std::vector<BiomeIndex::Point> queries = RandomPoints(rng, queryCount);
+
+  BenchmarkReport report("biome");
+
+  bool mismatch = false;
+  for (size_t biomeCount : {4, 8, 16, 32, 64, 128, 256})
+  {
+    // a repeated biome and queries sitting exactly on biome points, so ties get exercised
+    std::vector<BiomeIndex::Point> biomes = RandomPoints(rng, biomeCount);
+    biomes[biomeCount - 1] = biomes[0];
+    for (size_t i = 0; i < biomeCount; i++)
+      queries[i] = biomes[i];
+
+    BiomeIndex index;
+    double buildSeconds = MeasureSeconds([&]
+                                         { index.Build(biomes); });
+
+    std::vector<int> linear(queryCount), indexed(queryCount);
+    nlohmann::json params = {{"biomes", biomeCount}, {"queries", queryCount}};
+
+    double linearSeconds = BestOf(
+        repetitions, []
+        {},
+        [&]
+        {
+          for (size_t i = 0; i < queryCount; i++)
+            linear[i] = index.NearestLinear(queries[i]);
+          DoNotOptimize(linear[0]); });
+
+    double indexedSeconds = BestOf(
+        repetitions, []
+        {},
+        [&]
+        {
+          for (size_t i = 0; i < queryCount; i++)
+            indexed[i] = index.Nearest(queries[i]);
+          DoNotOptimize(indexed[0]); });
+
+    uint64_t mismatches = 0;
+    for (size_t i = 0; i < queryCount; i++)
+      mismatches += linear[i] != indexed[i];
+    mismatch |= mismatches > 0;
+
+    report.Add("biome_linear", params, queryCount, linearSeconds);
+    report.Add("biome_indexed", params, queryCount, indexedSeconds,
+               {{"speedup", indexedSeconds > 0.0 ? linearSeconds / indexedSeconds : 0.0},
+                {"mismatches", mismatches},
+                {"average_candidates", index.AverageCandidates()},
+                {"build_seconds", buildSeconds}});
+
+    if (mismatches > 0)
+      std::cerr << biomeCount << " biomes: " << mismatches << " queries picked a different biome than the linear scan" << std::endl;
+  }
+
+  report.Write(argc, argv);
+  return mismatch ? 1 : 0;
+}
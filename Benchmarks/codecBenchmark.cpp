@@ -0,0 +1,157 @@
+#include "benchmark.hpp"
+#include "terrainGenerator.hpp"
+#include "voxelCodec.hpp"
+
+#include <cstring>
+#include <vector>
+
+// Chunk compression ratio and throughput on generated terrain, for the palette, run and LZ codec the
+// region files and the unloaded chunk cache use and for the plain type and length runs it replaced.
+// Throughput is in bytes of raw voxel data, so encode and decode figures compare directly with a
+// memcpy of the chunk. Chunks are split into uniform ones (all air or all stone) and surface ones.
+// Usage: CodecBenchmark [--quick] [--out results.json]
+// Exits with 1 if a chunk does not decode back to the voxels it was encoded from.
+
+static const int REPETITIONS = 5;
+
+static void EncodePlainRuns(const std::vector<Voxel> &voxels, std::vector<uint8_t> &out)
+{
+  out.clear();
+  WriteVarint(out, voxels.size());
+  for (size_t i = 0; i < voxels.size();)
+  {
+    size_t run = 1;
+    while (i + run < voxels.size() && voxels[i + run].type == voxels[i].type)
+      run++;
+    WriteVarint(out, voxels[i].type);
+    WriteVarint(out, run);
+    i += run;
+  }
+}
+
+static bool DecodePlainRuns(const std::vector<uint8_t> &data, std::vector<Voxel> &voxels)
+{
+  const uint8_t *p = data.data();
+  const uint8_t *end = p + data.size();
+  uint64_t count;
+  if (!ReadVarint(p, end, count))
+    return false;
+
+  voxels.resize(count);
+  size_t i = 0;
+  while (i < count)
+  {
+    uint64_t type, run;
+    if (!ReadVarint(p, end, type) || !ReadVarint(p, end, run) || run > count - i)
+      return false;
+    std::fill(voxels.begin() + i, voxels.begin() + i + run, Voxel{(uint32_t)type});
+    i += run;
+  }
+  return p == end;
+}
+
+static bool Uniform(const std::vector<Voxel> &voxels)
+{
+  for (const Voxel &voxel : voxels)
+  {
+    if (voxel.type != voxels[0].type)
+      return false;
+  }
+  return true;
+}
+
+struct Codec
+{
+  const char *name;
+  void (*encode)(const std::vector<Voxel> &, std::vector<uint8_t> &);
+  bool (*decode)(const std::vector<uint8_t> &, std::vector<Voxel> &);
+};
+
+static bool DecodePaletteLZ(const std::vector<uint8_t> &data, std::vector<Voxel> &voxels)
+{
+  return DecodeVoxels(data.data(), data.size(), voxels);
+}
+
+int main(int argc, char **argv)
+{
+  const int radius = HasFlag(argc, argv, "--quick") ? 3 : 8;
+
+  Generator generator;
+  std::vector<std::vector<Voxel>> uniform, surface;
+  std::vector<std::vector<Voxel>> column(STACK);
+  for (int x = -radius; x < radius; x++)
+    for (int z = -radius; z < radius; z++)
+    {
+      generator.GenerateColumn(x, z, column);
+      for (auto &chunk : column)
+        (Uniform(chunk) ? uniform : surface).push_back(chunk);
+    }
+
+  const Codec codecs[] = {
+      {"palette_lz", EncodeVoxels, DecodePaletteLZ},
+      {"plain_runs", EncodePlainRuns, DecodePlainRuns},
+  };
+  const std::pair<const char *, const std::vector<std::vector<Voxel>> *> sets[] = {
+      {"uniform", &uniform},
+      {"surface", &surface},
+  };
+
+  BenchmarkReport report("codec");
+  uint64_t mismatches = 0;
+
+  for (const auto &[setName, chunks] : sets)
+  {
+    if (chunks->empty())
+      continue;
+
+    const uint64_t chunkCount = chunks->size();
+    const double rawBytes = (double)chunkCount * SIZE * SIZE * SIZE * sizeof(Voxel);
+
+    for (const Codec &codec : codecs)
+    {
+      std::vector<std::vector<uint8_t>> encoded(chunkCount);
+      double encodeSeconds = BestOf(
+          REPETITIONS, [] {}, [&]
+          {
+            for (size_t i = 0; i < chunkCount; i++)
+              codec.encode((*chunks)[i], encoded[i]);
+            DoNotOptimize(encoded[0][0]); });
+
+      uint64_t encodedBytes = 0;
+      for (const auto &data : encoded)
+        encodedBytes += data.size();
+
+      std::vector<Voxel> decoded;
+      double decodeSeconds = BestOf(
+          REPETITIONS, [] {}, [&]
+          {
+            for (size_t i = 0; i < chunkCount; i++)
+              codec.decode(encoded[i], decoded);
+            DoNotOptimize(decoded[0]); });
+
+      for (size_t i = 0; i < chunkCount; i++)
+      {
+        const std::vector<Voxel> &original = (*chunks)[i];
+        if (!codec.decode(encoded[i], decoded) || decoded.size() != original.size() ||
+            std::memcmp(decoded.data(), original.data(), original.size() * sizeof(Voxel)) != 0)
+          mismatches++;
+      }
+
+      nlohmann::json params = {{"codec", codec.name}, {"chunks", setName}, {"count", chunkCount}};
+      const double ratio = encodedBytes > 0 ? rawBytes / encodedBytes : 0.0;
+      report.Add(std::string("chunk_encode_") + codec.name, params, chunkCount, encodeSeconds,
+                 {{"encoded_bytes", encodedBytes},
+                  {"bytes_per_chunk", (double)encodedBytes / chunkCount},
+                  {"compression_ratio", ratio},
+                  {"raw_gb_per_second", encodeSeconds > 0.0 ? rawBytes / encodeSeconds / 1e9 : 0.0}});
+      report.Add(std::string("chunk_decode_") + codec.name, params, chunkCount, decodeSeconds,
+                 {{"raw_gb_per_second", decodeSeconds > 0.0 ? rawBytes / decodeSeconds / 1e9 : 0.0}});
+    }
+  }
+
+  if (mismatches > 0)
+    std::cerr << mismatches << " chunks did not decode back to the voxels they were encoded from" << std::endl;
+
+  report.Write(argc, argv);
+  return mismatches > 0 ? 1 : 0;
+}
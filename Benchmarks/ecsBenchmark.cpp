@@ -0,0 +1,215 @@
+#include "benchmark.hpp"
+#include "coordinator.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Headless benchmarks for the ECS core (entityManager.hpp, componentArray.hpp, system.hpp).
+// Usage: EcsBenchmark [--quick] [--out results.json]
+
+struct BenchPosition
+{
+  float x, y, z;
+};
+
+struct BenchVelocity
+{
+  float x, y, z;
+};
+
+class MovementSystem : public System
+{
+public:
+  void Update(Coordinator &coordinator, float dt)
+  {
+    for (auto const &entity : mEntities)
+    {
+      auto &position = coordinator.GetComponent<BenchPosition>(entity);
+      auto const &velocity = coordinator.GetComponent<BenchVelocity>(entity);
+
+      position.x += velocity.x * dt;
+      position.y += velocity.y * dt;
+      position.z += velocity.z * dt;
+    }
+  }
+};
+
+struct World
+{
+  std::unique_ptr<Coordinator> coordinator;
+  std::shared_ptr<MovementSystem> movementSystem;
+};
+
+static World CreateWorld()
+{
+  World world;
+  world.coordinator = std::make_unique<Coordinator>();
+  world.coordinator->Init();
+  world.coordinator->RegisterComponent<BenchPosition>();
+  world.coordinator->RegisterComponent<BenchVelocity>();
+
+  world.movementSystem = world.coordinator->RegisterSystem<MovementSystem>();
+  Signature signature;
+  signature.set(world.coordinator->GetComponentType<BenchPosition>());
+  signature.set(world.coordinator->GetComponentType<BenchVelocity>());
+  world.coordinator->SetSystemSignature<MovementSystem>(signature);
+
+  return world;
+}
+
+static std::vector<Entity> CreateEntities(Coordinator &coordinator, size_t count)
+{
+  std::vector<Entity> entities(count);
+  for (size_t i = 0; i < count; i++)
+    entities[i] = coordinator.CreateEntity();
+  return entities;
+}
+
+static void BenchmarkCreateDestroy(BenchmarkReport &report, size_t count, int repetitions)
+{
+  nlohmann::json params = {{"entities", count}};
+
+  World world = CreateWorld();
+  std::vector<Entity> entities;
+
+  double createSeconds = BestOf(
+      repetitions, [&]
+      {
+        for (Entity entity : entities)
+          world.coordinator->DestroyEntity(entity);
+        entities.clear(); },
+      [&]
+      { entities = CreateEntities(*world.coordinator, count); });
+  report.Add("entity_create", params, count, createSeconds);
+
+  double destroySeconds = BestOf(
+      repetitions, [&]
+      {
+        if (entities.empty())
+          entities = CreateEntities(*world.coordinator, count); },
+      [&]
+      {
+        for (Entity entity : entities)
+          world.coordinator->DestroyEntity(entity);
+        entities.clear(); });
+  report.Add("entity_destroy", params, count, destroySeconds);
+}
+
+static void BenchmarkComponentChurn(BenchmarkReport &report, size_t count, int repetitions)
+{
+  nlohmann::json params = {{"entities", count}};
+
+  World world = CreateWorld();
+  std::vector<Entity> entities = CreateEntities(*world.coordinator, count);
+  bool hasComponents = false;
+
+  double addSeconds = BestOf(
+      repetitions, [&]
+      {
+        if (hasComponents)
+        {
+          for (Entity entity : entities)
+            world.coordinator->RemoveComponent<BenchPosition>(entity);
+        }
+        hasComponents = false; },
+      [&]
+      {
+        for (Entity entity : entities)
+          world.coordinator->AddComponent(entity, BenchPosition{1.0f, 2.0f, 3.0f});
+        hasComponents = true; });
+  report.Add("component_add", params, count, addSeconds);
+
+  double removeSeconds = BestOf(
+      repetitions, [&]
+      {
+        if (!hasComponents)
+        {
+          for (Entity entity : entities)
+            world.coordinator->AddComponent(entity, BenchPosition{1.0f, 2.0f, 3.0f});
+        }
+        hasComponents = true; },
+      [&]
+      {
+        for (Entity entity : entities)
+          world.coordinator->RemoveComponent<BenchPosition>(entity);
+        hasComponents = false; });
+  report.Add("component_remove", params, count, removeSeconds);
+}
+
+static void BenchmarkRandomGet(BenchmarkReport &report, size_t count, int repetitions)
+{
+  nlohmann::json params = {{"entities", count}};
+
+  World world = CreateWorld();
+  std::vector<Entity> entities = CreateEntities(*world.coordinator, count);
+  for (Entity entity : entities)
+    world.coordinator->AddComponent(entity, BenchPosition{static_cast<float>(entity), 0.0f, 0.0f});
+
+  // fixed seed so every run visits the same order
+  std::mt19937 rng(1234);
+  std::shuffle(entities.begin(), entities.end(), rng);
+
+  float sum = 0.0f;
+  double seconds = BestOf(
+      repetitions, [&]
+      { sum = 0.0f; },
+      [&]
+      {
+        for (Entity entity : entities)
+          sum += world.coordinator->GetComponent<BenchPosition>(entity).x;
+        DoNotOptimize(sum); });
+  report.Add("component_get_random", params, count, seconds);
+}
+
+static void BenchmarkIteration(BenchmarkReport &report, size_t count, int repetitions)
+{
+  nlohmann::json params = {{"entities", count}};
+
+  World world = CreateWorld();
+  std::vector<Entity> entities = CreateEntities(*world.coordinator, count);
+  for (Entity entity : entities)
+  {
+    world.coordinator->AddComponent(entity, BenchPosition{0.0f, 0.0f, 0.0f});
+    world.coordinator->AddComponent(entity, BenchVelocity{1.0f, 0.5f, 0.25f});
+  }
+
+  double seconds = BestOf(
+      repetitions, []
+      {},
+      [&]
+      { world.movementSystem->Update(*world.coordinator, 1.0f / 60.0f); });
+
+  // component bytes read and written per pass, the lookup tables are not counted
+  double bytes = static_cast<double>(count) * (2 * sizeof(BenchPosition) + sizeof(BenchVelocity));
+  report.Add("system_iterate", params, count, seconds, {{"component_bytes_per_second", seconds > 0.0 ? bytes / seconds : 0.0}});
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<size_t> counts = {10000, 100000, 1000000};
+  if (HasFlag(argc, argv, "--quick"))
+    counts = {10000, 100000};
+
+  const int repetitions = 3;
+
+  BenchmarkReport report("ecs");
+  for (size_t count : counts)
+  {
+    if (count > MAX_ENTITIES)
+    {
+      std::cerr << "Skipping " << count << " entities, MAX_ENTITIES is " << MAX_ENTITIES << std::endl;
+      continue;
+    }
+
+    BenchmarkCreateDestroy(report, count, repetitions);
+    BenchmarkComponentChurn(report, count, repetitions);
+    BenchmarkRandomGet(report, count, repetitions);
+    BenchmarkIteration(report, count, repetitions);
+  }
+
+  report.Write(argc, argv);
+  return 0;
+}
@@ -0,0 +1,147 @@
+#include "benchmark.hpp"
+#include "noiseGrid.hpp"
+
+#include <cmath>
+#include <vector>
+
+// Scalar FastNoiseLite against the batched NoiseLayer::FillGrid and the coarse lattice
+// FillGridInterpolated, on the same 31x31 column grids the default terrain generator samples. Also
+// checks the batched output matches the scalar output.
+// Usage: NoiseBenchmark [--quick] [--out results.json]
+// Exits with 1 if any batched sample differs from FastNoiseLite.
+
+static const int GRID_SIZE = 31;
+
+struct LayerConfig
+{
+  const char *name;
+  NoiseSettings settings;
+};
+
+static NoiseSettings MakeSettings(int seed, FastNoiseLite::NoiseType type, float frequency, FastNoiseLite::FractalType fractal, int octaves, float lacunarity, float gain)
+{
+  NoiseSettings settings;
+  settings.seed = seed;
+  settings.noiseType = type;
+  settings.frequency = frequency;
+  settings.fractalType = fractal;
+  settings.octaves = octaves;
+  settings.lacunarity = lacunarity;
+  settings.gain = gain;
+  return settings;
+}
+
+// the layers DefaultVoxelSystem builds, plus FastNoiseLite's defaults
+static std::vector<LayerConfig> TerrainLayers()
+{
+  const auto perlin = FastNoiseLite::NoiseType_Perlin;
+  const auto simplex = FastNoiseLite::NoiseType_OpenSimplex2;
+  const auto fbm = FastNoiseLite::FractalType_FBm;
+  const auto none = FastNoiseLite::FractalType_None;
+
+  return {
+      {"elevation", MakeSettings(1337, perlin, 0.004f, fbm, 4, 4.0f, 0.7f)},
+      {"erosion", MakeSettings(1338, simplex, 0.03f, none, 3, 2.0f, 0.5f)},
+      {"continentalness", MakeSettings(1339, perlin, 0.004f, fbm, 4, 1.5f, 0.7f)},
+      {"weirdness", MakeSettings(1340, perlin, 0.0014f, fbm, 8, 1.5f, 0.9f)},
+      {"temperature", MakeSettings(1341, perlin, 0.01f, fbm, 2, 2.0f, 0.3f)},
+      {"simplex_fbm", MakeSettings(1342, simplex, 0.01f, fbm, 5, 2.0f, 0.5f)},
+      {"defaults", NoiseSettings()},
+  };
+}
+
+// column origins around the world origin, negative ones included since floor behaves differently there
+static std::vector<std::pair<float, float>> ColumnOrigins(int radius)
+{
+  std::vector<std::pair<float, float>> origins;
+  for (int x = -radius; x < radius; x++)
+    for (int z = -radius; z < radius; z++)
+      origins.push_back({(float)(x * GRID_SIZE), (float)(z * GRID_SIZE)});
+  return origins;
+}
+
+int main(int argc, char **argv)
+{
+  const int radius = HasFlag(argc, argv, "--quick") ? 4 : 16;
+  const int repetitions = 3;
+
+  const auto origins = ColumnOrigins(radius);
+  const uint64_t samples = (uint64_t)origins.size() * GRID_SIZE * GRID_SIZE;
+
+  std::vector<float> scalar(samples), batched(samples);
+
+  BenchmarkReport report("noise");
+  std::cerr << "Batched noise path: " << NoiseBatchPath() << std::endl;
+
+  bool mismatch = false;
+  for (const LayerConfig &config : TerrainLayers())
+  {
+    NoiseLayer layer(config.settings);
+    nlohmann::json params = {{"layer", config.name}, {"octaves", config.settings.octaves}, {"columns", origins.size()}};
+
+    double scalarSeconds = BestOf(
+        repetitions, []
+        {},
+        [&]
+        {
+          for (size_t c = 0; c < origins.size(); c++)
+            layer.FillGridScalar(scalar.data() + c * GRID_SIZE * GRID_SIZE, GRID_SIZE, GRID_SIZE, origins[c].first, origins[c].second);
+          DoNotOptimize(scalar[0]); });
+
+    double batchedSeconds = BestOf(
+        repetitions, []
+        {},
+        [&]
+        {
+          for (size_t c = 0; c < origins.size(); c++)
+            layer.FillGrid(batched.data() + c * GRID_SIZE * GRID_SIZE, GRID_SIZE, GRID_SIZE, origins[c].first, origins[c].second);
+          DoNotOptimize(batched[0]); });
+
+    double maxError = 0.0;
+    uint64_t mismatches = 0;
+    for (uint64_t i = 0; i < samples; i++)
+    {
+      if (scalar[i] == batched[i])
+        continue;
+
+      mismatches++;
+      maxError = std::max(maxError, (double)std::fabs(scalar[i] - batched[i]));
+    }
+    mismatch |= mismatches > 0;
+
+    report.Add("noise_scalar", params, samples, scalarSeconds);
+    report.Add("noise_batched", params, samples, batchedSeconds,
+               {{"path", NoiseBatchPath()},
+                {"batched", layer.IsBatched()},
+                {"speedup", batchedSeconds > 0.0 ? scalarSeconds / batchedSeconds : 0.0},
+                {"mismatches", mismatches},
+                {"max_abs_error", maxError}});
+
+    // coarse lattice sampling, the error is against full resolution and expected to be nonzero
+    for (int stride : {4, 8})
+    {
+      double interpolatedSeconds = BestOf(
+          repetitions, []
+          {},
+          [&]
+          {
+            for (size_t c = 0; c < origins.size(); c++)
+              layer.FillGridInterpolated(batched.data() + c * GRID_SIZE * GRID_SIZE, GRID_SIZE, GRID_SIZE, (int)origins[c].first, (int)origins[c].second, stride);
+            DoNotOptimize(batched[0]); });
+
+      double interpolationError = 0.0;
+      for (uint64_t i = 0; i < samples; i++)
+        interpolationError = std::max(interpolationError, (double)std::fabs(scalar[i] - batched[i]));
+
+      nlohmann::json strideParams = params;
+      strideParams["stride"] = stride;
+      report.Add("noise_interpolated", strideParams, samples, interpolatedSeconds, {{"max_abs_error", interpolationError}});
+    }
+
+    if (mismatches > 0)
+      std::cerr << config.name << ": " << mismatches << " samples differ from FastNoiseLite, max error " << maxError << std::endl;
+  }
+
+  report.Write(argc, argv);
+  return mismatch ? 1 : 0;
+}
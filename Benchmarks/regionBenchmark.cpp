@@ -0,0 +1,91 @@
+#include "benchmark.hpp"
+#include "regionStorage.hpp"
+#include "terrainGenerator.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+// Chunk load throughput from region files against generating the same chunks. Generation samples
+// the six noise layers DefaultVoxelSystem uses once per column, as its column cache does, and fills
+// a stack of chunks from the heights. Loading writes those chunks to region files first, then times
+// reading and decoding them back from a freshly opened storage, so every region is mapped again.
+// Usage: RegionBenchmark [--quick] [--out results.json] [--dir region_directory]
+// Exits with 1 if a loaded chunk differs from the generated one.
+
+static std::string DirectoryArgument(int argc, char **argv)
+{
+  for (int i = 1; i + 1 < argc; i++)
+  {
+    if (std::strcmp(argv[i], "--dir") == 0)
+      return argv[i + 1];
+  }
+  return (std::filesystem::temp_directory_path() / "region_benchmark").string();
+}
+
+int main(int argc, char **argv)
+{
+  const int radius = HasFlag(argc, argv, "--quick") ? 4 : 12;
+  const std::string directory = DirectoryArgument(argc, argv);
+  std::filesystem::remove_all(directory);
+
+  std::vector<std::pair<int, int>> columns;
+  for (int x = -radius; x < radius; x++)
+    for (int z = -radius; z < radius; z++)
+      columns.push_back({x, z});
+  const uint64_t chunkCount = (uint64_t)columns.size() * STACK;
+
+  Generator generator;
+  std::vector<std::vector<std::vector<Voxel>>> generated(columns.size(), std::vector<std::vector<Voxel>>(STACK));
+
+  double generateSeconds = MeasureSeconds([&]
+                                          {
+                                            for (size_t c = 0; c < columns.size(); c++)
+                                              generator.GenerateColumn(columns[c].first, columns[c].second, generated[c]);
+                                            DoNotOptimize(generated[0][0][0]); });
+
+  RegionStorage storage;
+  if (!storage.Open(directory))
+    return 1;
+
+  double writeSeconds = MeasureSeconds([&]
+                                       {
+                                         for (size_t c = 0; c < columns.size(); c++)
+                                           for (int y = 0; y < STACK; y++)
+                                             storage.Write(columns[c].first, y, columns[c].second, 0, generated[c][y]); });
+  const uint64_t bytesWritten = storage.BytesWritten();
+
+  // reopening drops the cached tables and mappings, the first read of every region reads its table again
+  std::vector<Voxel> loaded;
+  uint64_t mismatches = 0;
+  double readSeconds = MeasureSeconds([&]
+                                      {
+                                        storage.Open(directory);
+                                        for (size_t c = 0; c < columns.size(); c++)
+                                          for (int y = 0; y < STACK; y++)
+                                          {
+                                            int lod;
+                                            if (!storage.Read(columns[c].first, y, columns[c].second, 0, loaded, lod) ||
+                                                loaded.size() != generated[c][y].size() ||
+                                                std::memcmp(loaded.data(), generated[c][y].data(), loaded.size() * sizeof(Voxel)) != 0)
+                                              mismatches++;
+                                          } });
+  storage.Close();
+  std::filesystem::remove_all(directory);
+
+  nlohmann::json params = {{"chunks", chunkCount}, {"noise_path", NoiseBatchPath()}};
+  const double rawBytes = (double)chunkCount * SIZE * SIZE * SIZE * sizeof(Voxel);
+
+  BenchmarkReport report("region");
+  report.Add("chunk_generate", params, chunkCount, generateSeconds);
+  report.Add("chunk_region_write", params, chunkCount, writeSeconds,
+             {{"bytes_written", bytesWritten}, {"compression_ratio", bytesWritten > 0 ? rawBytes / bytesWritten : 0.0}});
+  report.Add("chunk_region_load", params, chunkCount, readSeconds,
+             {{"speedup_over_generate", readSeconds > 0.0 ? generateSeconds / readSeconds : 0.0}, {"mismatches", mismatches}});
+
+  if (mismatches > 0)
+    std::cerr << mismatches << " chunks loaded from region files differ from the generated ones" << std::endl;
+
+  report.Write(argc, argv);
+  return mismatches > 0 ? 1 : 0;
+}
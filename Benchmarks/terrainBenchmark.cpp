@@ -0,0 +1,163 @@
+#include "benchmark.hpp"
+#include "terrainFill.hpp"
+
+#include <random>
+#include <vector>
+
+// Chunk voxel fill throughput: the old per voxel loop (TerrainBlockAt plus the flipped index for
+// every voxel) against run fills per column with whole chunk early outs, as
+// DefaultVoxelSystem::GenerateVoxelData does. Columns are synthetic so noise cost is left out.
+// Usage: TerrainBenchmark [--quick] [--out results.json]
+// Exits with 1 if the two ever produce different voxels.
+
+struct Column
+{
+  std::vector<int> height;
+  std::vector<uint16_t> biome;
+  int maxHeight;
+  int stoneTop;
+};
+
+static std::vector<Biome> MakeBiomes()
+{
+  std::vector<Biome> biomes;
+  for (uint16_t i = 0; i < 4; i++)
+  {
+    Biome biome{};
+    biome.airBlock = 0;
+    biome.topBlock = 1 + i;
+    biome.fillerBlock = 5 + i;
+    biome.stoneBlock = 9;
+    biome.waterBlock = 10;
+    biome.bottomBlock = 11;
+    biome.topDepth = 1 + i;
+    biome.fillerDepth = 3 + i;
+    biomes.push_back(biome);
+  }
+  return biomes;
+}
+
+static Column MakeColumn(std::mt19937 &rng, const std::vector<Biome> &biomes, int minHeight, int maxHeight)
+{
+  std::uniform_int_distribution<int> heightDist(minHeight, maxHeight);
+  std::uniform_int_distribution<int> biomeDist(0, (int)biomes.size() - 1);
+
+  Column column;
+  column.height.resize(CHUNK_SIZE * CHUNK_SIZE);
+  column.biome.resize(CHUNK_SIZE * CHUNK_SIZE);
+  for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++)
+  {
+    column.height[i] = heightDist(rng);
+    column.biome[i] = (uint16_t)biomeDist(rng);
+  }
+
+  column.maxHeight = column.height[0];
+  column.stoneTop = column.height[0];
+  for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++)
+  {
+    const Biome &biome = biomes[column.biome[i]];
+    column.maxHeight = std::max(column.maxHeight, column.height[i]);
+    column.stoneTop = std::min(column.stoneTop, column.height[i] - biome.topDepth - biome.fillerDepth);
+  }
+  return column;
+}
+
+static void FillPerVoxel(std::vector<Voxel> &voxels, const Column &column, const std::vector<Biome> &biomes, int chunkY, int waterLevel)
+{
+  for (int x = 0; x < CHUNK_SIZE; x++)
+    for (int z = 0; z < CHUNK_SIZE; z++)
+    {
+      int i = x + CHUNK_SIZE * z;
+      for (int y = 0; y < CHUNK_SIZE; y++)
+      {
+        int flippedY = CHUNK_SIZE - y - 1;
+        voxels[x + CHUNK_SIZE * z + CHUNK_SIZE * CHUNK_SIZE * flippedY].type = TerrainBlockAt(biomes[column.biome[i]], chunkY * CHUNK_SIZE + y, column.height[i], waterLevel);
+      }
+    }
+}
+
+static void FillSpans(std::vector<Voxel> &voxels, const Column &column, const std::vector<Biome> &biomes, int chunkY, int waterLevel)
+{
+  const int topY = chunkY * CHUNK_SIZE + CHUNK_SIZE - 1;
+  const int bottomY = chunkY * CHUNK_SIZE;
+
+  // every synthetic biome shares its air and stone blocks
+  if (bottomY > std::max(column.maxHeight, waterLevel))
+  {
+    std::fill(voxels.begin(), voxels.end(), Voxel{biomes[0].airBlock});
+    return;
+  }
+  if (topY < column.stoneTop && bottomY > 0)
+  {
+    std::fill(voxels.begin(), voxels.end(), Voxel{biomes[0].stoneBlock});
+    return;
+  }
+
+  for (int z = 0; z < CHUNK_SIZE; z++)
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+      int i = x + CHUNK_SIZE * z;
+      FillTerrainColumn(voxels.data() + i, CHUNK_SIZE * CHUNK_SIZE, CHUNK_SIZE, topY, 1, column.height[i], waterLevel, biomes[column.biome[i]]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+  const int repetitions = HasFlag(argc, argv, "--quick") ? 3 : 10;
+  const int waterLevel = 48;
+  const int columnCount = 16;
+
+  std::mt19937 rng(1234);
+  const std::vector<Biome> biomes = MakeBiomes();
+
+  std::vector<Column> columns;
+  for (int i = 0; i < columnCount; i++)
+    columns.push_back(MakeColumn(rng, biomes, 32, 96));
+
+  BenchmarkReport report("terrain");
+  bool mismatch = false;
+
+  // chunk -1 is all bottom blocks, 0 is mostly stone, 1 to 3 cut through the surface, 4 and up are open air
+  for (int chunkY : {-1, 0, 1, 2, 3, 4, 6})
+  {
+    nlohmann::json params = {{"chunk_y", chunkY}, {"chunks", columnCount}};
+    const uint64_t voxelCount = (uint64_t)columnCount * CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+    std::vector<std::vector<Voxel>> before(columnCount, std::vector<Voxel>(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE));
+    std::vector<std::vector<Voxel>> after(columnCount, std::vector<Voxel>(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE));
+
+    double beforeSeconds = BestOf(
+        repetitions, []
+        {},
+        [&]
+        {
+          for (int c = 0; c < columnCount; c++)
+            FillPerVoxel(before[c], columns[c], biomes, chunkY, waterLevel);
+          DoNotOptimize(before[0][0]); });
+
+    double afterSeconds = BestOf(
+        repetitions, []
+        {},
+        [&]
+        {
+          for (int c = 0; c < columnCount; c++)
+            FillSpans(after[c], columns[c], biomes, chunkY, waterLevel);
+          DoNotOptimize(after[0][0]); });
+
+    uint64_t mismatches = 0;
+    for (int c = 0; c < columnCount; c++)
+      for (size_t i = 0; i < before[c].size(); i++)
+        mismatches += before[c][i].type != after[c][i].type;
+    mismatch |= mismatches > 0;
+
+    report.Add("fill_per_voxel", params, voxelCount, beforeSeconds);
+    report.Add("fill_spans", params, voxelCount, afterSeconds,
+               {{"speedup", afterSeconds > 0.0 ? beforeSeconds / afterSeconds : 0.0}, {"mismatches", mismatches}});
+
+    if (mismatches > 0)
+      std::cerr << "chunk y " << chunkY << ": " << mismatches << " voxels differ between the two fills" << std::endl;
+  }
+
+  report.Write(argc, argv);
+  return mismatch ? 1 : 0;
+}
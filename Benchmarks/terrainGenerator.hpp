@@ -0,0 +1,75 @@
+#pragma once
+#include "noiseGrid.hpp"
+#include "terrainFill.hpp"
+
+#include <vector>
+
+// Stand-in for DefaultVoxelSystem's generation the storage benchmarks can run without glm or the
+// ECS: the same six noise layers sampled once per column, as its column cache does, and a stack of
+// chunks filled from the heights with one biome.
+
+static const int SIZE = 31; // CHUNK_SIZE, components.hpp needs glm
+static const int STACK = 4; // chunks generated per column
+static const int WATER_LEVEL = 48;
+
+struct Generator
+{
+  NoiseLayer layers[6];
+  Biome biome{};
+
+  Generator()
+  {
+    const auto perlin = FastNoiseLite::NoiseType_Perlin;
+    const auto simplex = FastNoiseLite::NoiseType_OpenSimplex2;
+    const auto fbm = FastNoiseLite::FractalType_FBm;
+    const auto none = FastNoiseLite::FractalType_None;
+
+    const NoiseSettings settings[6] = {
+        {213, perlin, 0.004f, fbm, 4, 4.0f, 0.7f},
+        {214, simplex, 0.03f, none, 3, 2.0f, 0.5f},
+        {215, perlin, 0.004f, fbm, 4, 1.5f, 0.7f},
+        {216, perlin, 0.0014f, fbm, 8, 1.5f, 0.9f},
+        {217, perlin, 0.01f, fbm, 2, 2.0f, 0.3f},
+        {218, perlin, 0.017f, fbm, 2, 2.0f, 0.3f},
+    };
+    for (int i = 0; i < 6; i++)
+    {
+      layers[i].Configure(settings[i]);
+      layers[i].SetSampling(8, 0.01f);
+    }
+
+    biome.airBlock = 0;
+    biome.topBlock = 1;
+    biome.fillerBlock = 2;
+    biome.stoneBlock = 3;
+    biome.waterBlock = 4;
+    biome.bottomBlock = 3;
+    biome.topDepth = 1;
+    biome.fillerDepth = 3;
+  }
+
+  // fills STACK chunks of the column at chunk (x, z), chunk y 0 first
+  void GenerateColumn(int chunkX, int chunkZ, std::vector<std::vector<Voxel>> &chunks) const
+  {
+    float grids[6][SIZE * SIZE];
+    for (int i = 0; i < 6; i++)
+      layers[i].FillGridSampled(grids[i], SIZE, SIZE, chunkX * SIZE, chunkZ * SIZE);
+
+    int heights[SIZE * SIZE];
+    for (int i = 0; i < SIZE * SIZE; i++)
+    {
+      float combined = 0.0f;
+      for (int l = 0; l < 6; l++)
+        combined += 0.5f + 0.5f * grids[l][i];
+      heights[i] = 16 + (int)(combined / 6.0f * 96.0f);
+    }
+
+    for (int y = 0; y < STACK; y++)
+    {
+      std::vector<Voxel> &voxels = chunks[y];
+      voxels.resize(SIZE * SIZE * SIZE);
+      for (int i = 0; i < SIZE * SIZE; i++)
+        FillTerrainColumn(voxels.data() + i, SIZE * SIZE, SIZE, y * SIZE + SIZE - 1, 1, heights[i], WATER_LEVEL, biome);
+    }
+  }
+};
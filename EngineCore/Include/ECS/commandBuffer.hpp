@@ -0,0 +1,97 @@
+#pragma once
+
+#include "types.hpp"
+#include "componentManager.hpp"
+#include "entityManager.hpp"
+#include <vector>
+#include <functional>
+#include <mutex>
+
+// Records structural changes (create, destroy, add, remove) while systems iterate so they can be
+// played back in one batch at a sync point. Each thread records into its own buffer.
+class CommandBuffer
+{
+public:
+    enum class CommandType
+    {
+        Create,
+        Destroy,
+        Add,
+        Remove
+    };
+
+    struct Command
+    {
+        CommandType type;
+        Entity entity;
+
+        // for Add/Remove: applies the change to the component arrays and returns the component type
+        std::function<ComponentType(ComponentManager &, Entity)> apply;
+    };
+
+    void Init(EntityManager *entityManager, std::mutex *entityMutex)
+    {
+        mEntityManager = entityManager;
+        mEntityMutex = entityMutex;
+    }
+
+    // The id is reserved right away so later commands can refer to it, the entity stays
+    // invisible to systems until its components are added on playback.
+    Entity CreateEntity()
+    {
+        Entity entity;
+        {
+            std::lock_guard<std::mutex> lock(*mEntityMutex);
+            entity = mEntityManager->CreateEntity();
+        }
+
+        mCommands.push_back({CommandType::Create, entity, nullptr});
+        return entity;
+    }
+
+    void DestroyEntity(Entity entity)
+    {
+        mCommands.push_back({CommandType::Destroy, entity, nullptr});
+    }
+
+    template <typename T>
+    void AddComponent(Entity entity, T component)
+    {
+        mCommands.push_back({CommandType::Add, entity, [component = std::move(component)](ComponentManager &componentManager, Entity e)
+                             {
+                                 componentManager.AddComponent<T>(e, component);
+                                 return componentManager.GetComponentType<T>();
+                             }});
+    }
+
+    template <typename T>
+    void RemoveComponent(Entity entity)
+    {
+        mCommands.push_back({CommandType::Remove, entity, [](ComponentManager &componentManager, Entity e)
+                             {
+                                 componentManager.RemoveComponent<T>(e);
+                                 return componentManager.GetComponentType<T>();
+                             }});
+    }
+
+    bool Empty() const
+    {
+        return mCommands.empty();
+    }
+
+    void Clear()
+    {
+        mCommands.clear();
+    }
+
+    const std::vector<Command> &GetCommands() const
+    {
+        return mCommands;
+    }
+
+private:
+    std::vector<Command> mCommands{};
+
+    EntityManager *mEntityManager = nullptr;
+    std::mutex *mEntityMutex = nullptr;
+};
@@ -5,6 +5,7 @@
 #include <memory>
 #include <iostream>
 #include <cassert>
+#include <utility>
 
 class IComponentArray
 {
@@ -25,7 +26,7 @@ public:
         size_t newIndex = mSize;
         mEntityToIndexMap[entity] = newIndex;
         mIndexToEntityMap[newIndex] = entity;
-        mComponentArray[newIndex] = component;
+        mComponentArray[newIndex] = std::move(component);
         ++mSize;
     }
 
@@ -33,10 +34,14 @@ public:
     {
         assert(mEntityToIndexMap.find(entity) != mEntityToIndexMap.end() && "Removing non-existent component.");
 
-        // Copy element at end into deleted element's place to maintain density
+        // Move element at end into deleted element's place to maintain density, heap data such as
+        // chunk voxels keeps its address
         size_t indexOfRemovedEntity = mEntityToIndexMap[entity];
         size_t indexOfLastElement = mSize - 1;
-        mComponentArray[indexOfRemovedEntity] = mComponentArray[indexOfLastElement];
+        if (indexOfRemovedEntity != indexOfLastElement)
+            mComponentArray[indexOfRemovedEntity] = std::move(mComponentArray[indexOfLastElement]);
+        else
+            mComponentArray[indexOfRemovedEntity] = T{};
 
         // Update map to point to moved spot
         Entity entityOfLastElement = mIndexToEntityMap[indexOfLastElement];
@@ -56,10 +61,11 @@ public:
 
     T &GetData(Entity entity)
     {
-        assert(mEntityToIndexMap.find(entity) != mEntityToIndexMap.end() && "Retrieving non-existent component.");
+        auto it = mEntityToIndexMap.find(entity);
+        assert(it != mEntityToIndexMap.end() && "Retrieving non-existent component.");
 
-        // Return a reference to the entity's component
-        return mComponentArray[mEntityToIndexMap[entity]];
+        // Return a reference to the entity's component (lookup only, so concurrent reads are safe)
+        return mComponentArray[it->second];
     }
 
     void EntityDestroyed(Entity entity) override
@@ -29,13 +29,13 @@ public:
 
         assert(mComponentTypes.find(typeName) != mComponentTypes.end() && "Component not registered before use.");
 
-        return mComponentTypes[typeName];
+        return mComponentTypes.at(typeName);
     }
 
     template <typename T>
     void AddComponent(Entity entity, T component)
     {
-        GetComponentArray<T>()->InsertData(entity, component);
+        GetComponentArray<T>()->InsertData(entity, std::move(component));
     }
 
     template <typename T>
@@ -86,6 +86,6 @@ private:
 
         assert(mComponentTypes.find(typeName) != mComponentTypes.end() && "Component not registered before use.");
 
-        return std::static_pointer_cast<ComponentArray<T>>(mComponentArrays[typeName]);
+        return std::static_pointer_cast<ComponentArray<T>>(mComponentArrays.at(typeName));
     }
 };
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "componentManager.hpp"
 #include "entityManager.hpp"
 #include "system.hpp"
+#include "commandBuffer.hpp"
+#include <mutex>
+#include <unordered_set>
 
 class Coordinator
 {
@@ -13,17 +16,24 @@ public:
         mComponentManager = std::make_unique<ComponentManager>();
         mEntityManager = std::make_unique<EntityManager>();
         mSystemManager = std::make_unique<SystemManager>();
+
+        ResizeCommandBuffers(mSystemManager->GetThreadCount());
     }
 
     // Entity methods
     Entity CreateEntity()
     {
+        std::lock_guard<std::mutex> lock(mEntityMutex);
         return mEntityManager->CreateEntity();
     }
 
     void DestroyEntity(Entity entity)
     {
-        mEntityManager->DestroyEntity(entity);
+        {
+            // the id goes back to the free list that command buffers reserve from on worker threads
+            std::lock_guard<std::mutex> lock(mEntityMutex);
+            mEntityManager->DestroyEntity(entity);
+        }
 
         mComponentManager->EntityDestroyed(entity);
 
@@ -40,7 +50,7 @@ public:
     template <typename T>
     void AddComponent(Entity entity, T component)
     {
-        mComponentManager->AddComponent<T>(entity, component);
+        mComponentManager->AddComponent<T>(entity, std::move(component));
 
         auto signature = mEntityManager->GetSignature(entity);
         signature.set(mComponentManager->GetComponentType<T>(), true);
@@ -92,8 +102,131 @@ public:
         mSystemManager->SetSignature<T>(signature);
     }
 
+    template <typename T>
+    void SetSystemAccess(Signature reads, Signature writes)
+    {
+        mSystemManager->SetAccess<T>(reads, writes);
+    }
+
+    template <typename T>
+    void ScheduleSystem(std::function<void()> job)
+    {
+        mSystemManager->Schedule<T>(std::move(job));
+    }
+
+    // Runs the scheduled systems, then plays back the structural changes they recorded
+    void RunSystems()
+    {
+        mSystemManager->RunScheduled();
+        FlushCommandBuffers();
+    }
+
+    // Command buffer of the calling thread, structural changes made while iterating go through here
+    CommandBuffer &GetCommandBuffer()
+    {
+        unsigned int index = ThreadPool::CurrentThreadIndex();
+        assert(index < mCommandBuffers.size() && "Command buffer requested from an unknown thread.");
+
+        return *mCommandBuffers[index];
+    }
+
+    // Applies every recorded command in thread order. Component arrays are updated as commands are
+    // replayed but systems are only notified once per entity with its final signature. Buffers are
+    // not replayed in recording order, so commands for an entity destroyed earlier in the playback
+    // are dropped instead of bringing its id back to life.
+    void FlushCommandBuffers()
+    {
+        std::vector<Entity> touched;
+        std::unordered_map<Entity, Signature> signatures;
+        std::unordered_set<Entity> destroyed;
+
+        for (auto &buffer : mCommandBuffers)
+        {
+            for (auto const &command : buffer->GetCommands())
+            {
+                Entity entity = command.entity;
+
+                switch (command.type)
+                {
+                case CommandBuffer::CommandType::Create:
+                    // the id was reserved when the command was recorded
+                    break;
+                case CommandBuffer::CommandType::Destroy:
+                    if (!destroyed.insert(entity).second)
+                        break; // destroyed by another thread's buffer too
+                    DestroyEntity(entity);
+                    signatures.erase(entity);
+                    break;
+                case CommandBuffer::CommandType::Add:
+                case CommandBuffer::CommandType::Remove:
+                {
+                    if (destroyed.count(entity))
+                        break;
+
+                    auto it = signatures.find(entity);
+                    if (it == signatures.end())
+                    {
+                        it = signatures.emplace(entity, mEntityManager->GetSignature(entity)).first;
+                        touched.push_back(entity);
+                    }
+
+                    ComponentType type = command.apply(*mComponentManager, entity);
+                    it->second.set(type, command.type == CommandBuffer::CommandType::Add);
+                    break;
+                }
+                }
+            }
+
+            buffer->Clear();
+        }
+
+        for (Entity entity : touched)
+        {
+            auto it = signatures.find(entity);
+            if (it == signatures.end())
+                continue; // destroyed during playback
+
+            mEntityManager->SetSignature(entity, it->second);
+            mSystemManager->EntitySignatureChanged(entity, it->second);
+        }
+    }
+
+    void ParallelForEach(const System &system, size_t grainSize, const std::function<void(Entity)> &fn)
+    {
+        mSystemManager->ParallelForEach(system, grainSize, fn);
+    }
+
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &fn)
+    {
+        mSystemManager->ParallelFor(count, grainSize, fn);
+    }
+
+    void SetThreadCount(unsigned int threadCount)
+    {
+        FlushCommandBuffers();
+        mSystemManager->SetThreadCount(threadCount);
+        ResizeCommandBuffers(threadCount);
+    }
+
 private:
     std::unique_ptr<ComponentManager> mComponentManager;
     std::unique_ptr<EntityManager> mEntityManager;
     std::unique_ptr<SystemManager> mSystemManager;
+
+    // one buffer for the main thread plus one per worker
+    std::vector<std::unique_ptr<CommandBuffer>> mCommandBuffers;
+    std::mutex mEntityMutex;
+
+    void ResizeCommandBuffers(unsigned int threadCount)
+    {
+        mCommandBuffers.resize(threadCount + 1);
+        for (auto &buffer : mCommandBuffers)
+        {
+            if (!buffer)
+            {
+                buffer = std::make_unique<CommandBuffer>();
+                buffer->Init(mEntityManager.get(), &mEntityMutex);
+            }
+        }
+    }
 };
\ No newline at end of file
@@ -2,24 +2,50 @@
 #include <memory>
 #include <utility>
 #include <functional>
+#include <vector>
+#include <vulkan/vulkan.h>
 
 #include "coordinator.hpp"
 #include "types.hpp"
 #include "components.hpp"
 #include "camera.hpp"
+#include "transformSystem.hpp"
 class RenderSystem;
 class Renderer;
 class RenderSystem : public System
 {
 public:
     std::shared_ptr<Coordinator> gCoordinator;
+    std::shared_ptr<TransformSystem> transformSystem;
     int screenWidth;
     int screenHeight;
 
-    void Init(std::shared_ptr<Coordinator> coordinator, int screenWidth, int screenHeight);
+    // recorded after the scene inside the same render pass, for debug overlays
+    std::function<void(VkCommandBuffer)> drawOverlay;
+
+    // draws recorded in the last frame
+    struct Stats
+    {
+        uint32_t meshDraws = 0;
+        uint32_t meshInstances = 0;
+        uint32_t voxelDraws = 0;
+    };
+    Stats stats;
+
+    void Init(std::shared_ptr<Coordinator> coordinator, std::shared_ptr<TransformSystem> transformSystem, int screenWidth, int screenHeight);
     void Update(Renderer &renderer, float deltaTime, const Camera &camera);
     void RenderScene(Renderer &renderer, float deltaTime, const Camera &camera);
 
 private:
-    glm::mat4 getWorldMatrix(Entity entity);
+    struct MeshInstance
+    {
+        Mesh *mesh;
+        VkDescriptorSet imageSet;
+        Entity entity;
+    };
+
+    // reused every frame to avoid reallocating
+    std::vector<MeshInstance> meshInstances;
+
+    void DrawMeshInstances(Renderer &renderer, VkDescriptorSet cameraSet);
 };
\ No newline at end of file
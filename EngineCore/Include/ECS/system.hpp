@@ -1,16 +1,33 @@
 #pragma once
 
 #include "types.hpp"
+#include "threadPool.hpp"
 #include <set>
+#include <vector>
 #include <unordered_map>
 #include <memory>
+#include <functional>
 #include <cassert>
+#include <mutex>
+#include <thread>
 
 class System
 {
 public:
     std::set<Entity> mEntities;
     Signature mSignature;
+
+    // Components the system reads and writes while it runs. Scheduled systems whose access
+    // does not conflict run concurrently, a system that declares nothing runs exclusively.
+    Signature mReads;
+    Signature mWrites;
+
+    // Bumped whenever an entity joins or leaves mEntities, lets systems rebuild cached layouts lazily
+    uint64_t mVersion = 0;
+
+    // Scheduled jobs of the system run on the thread that calls RunScheduled, for systems that submit
+    // to the GPU queues the renderer uses from that thread. Other systems still overlap with them.
+    bool mMainThread = false;
 };
 
 class SystemManager
@@ -40,13 +57,121 @@ public:
         mSystems[typeName]->mSignature = signature;
     }
 
+    template <typename T>
+    void SetAccess(Signature reads, Signature writes)
+    {
+        const char *typeName = typeid(T).name();
+
+        assert(mSystems.find(typeName) != mSystems.end() && "System used before registered.");
+
+        mSystems[typeName]->mReads = reads;
+        mSystems[typeName]->mWrites = writes;
+    }
+
+    // Queues a job for system T to run during the next RunScheduled call
+    template <typename T>
+    void Schedule(std::function<void()> job)
+    {
+        const char *typeName = typeid(T).name();
+
+        assert(mSystems.find(typeName) != mSystems.end() && "System used before registered.");
+
+        mScheduled.push_back({mSystems[typeName].get(), std::move(job)});
+    }
+
+    // Runs every scheduled job and waits for all of them. A job depends on every earlier job it
+    // conflicts with, so conflicting systems keep their submission order and the rest run in parallel.
+    // Jobs of main thread systems run here once their dependencies are done, in between pool tasks.
+    void RunScheduled()
+    {
+        const size_t count = mScheduled.size();
+
+        if (mThreadPool.IsSingleThreaded())
+        {
+            for (auto &job : mScheduled)
+                job.run();
+            mScheduled.clear();
+            return;
+        }
+
+        // shared with every submitted task so nothing dangles if a worker is still unwinding after the last job
+        auto graph = std::make_shared<JobGraph>();
+        graph->jobs = std::move(mScheduled);
+        graph->dependents.resize(count);
+        graph->remaining.reset(new std::atomic<uint32_t>[count]);
+        graph->pending = static_cast<uint32_t>(count);
+
+        for (size_t j = 0; j < count; j++)
+        {
+            uint32_t dependencies = 0;
+            for (size_t i = 0; i < j; i++)
+            {
+                if (Conflicts(*graph->jobs[i].system, *graph->jobs[j].system))
+                {
+                    graph->dependents[i].push_back(j);
+                    dependencies++;
+                }
+            }
+            graph->remaining[j] = dependencies;
+        }
+
+        // collect the roots before submitting anything, running jobs decrement the counters concurrently
+        std::vector<size_t> roots;
+        for (size_t j = 0; j < count; j++)
+        {
+            if (graph->remaining[j] == 0)
+                roots.push_back(j);
+        }
+
+        for (size_t j : roots)
+            SubmitJob(graph, j);
+
+        while (graph->pending > 0)
+        {
+            size_t index;
+            if (PopMainThreadJob(*graph, index))
+                RunJob(graph, index);
+            else if (!mThreadPool.RunTask())
+                std::this_thread::yield();
+        }
+        mScheduled.clear();
+    }
+
+    // Runs fn for every entity of the system, split into slices of grainSize entities across the worker threads
+    void ParallelForEach(const System &system, size_t grainSize, const std::function<void(Entity)> &fn)
+    {
+        std::vector<Entity> entities(system.mEntities.begin(), system.mEntities.end());
+
+        mThreadPool.ParallelFor(entities.size(), grainSize, [&](size_t begin, size_t end)
+                                {
+                                    for (size_t i = begin; i < end; i++)
+                                        fn(entities[i]); });
+    }
+
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &fn)
+    {
+        mThreadPool.ParallelFor(count, grainSize, fn);
+    }
+
+    // 0 threads runs all systems and parallel loops on the calling thread in a deterministic order
+    void SetThreadCount(unsigned int threadCount)
+    {
+        mThreadPool.SetThreadCount(threadCount);
+    }
+
+    unsigned int GetThreadCount() const
+    {
+        return mThreadPool.GetThreadCount();
+    }
+
     void EntityDestroyed(Entity entity)
     {
         for (auto const &pair : mSystems)
         {
             auto const &system = pair.second;
 
-            system->mEntities.erase(entity);
+            if (system->mEntities.erase(entity))
+                system->mVersion++;
         }
     }
 
@@ -54,23 +179,89 @@ public:
     {
         for (auto const &pair : mSystems)
         {
-            auto const &type = pair.first;
             auto const &system = pair.second;
             auto const &systemSignature = system->mSignature;
 
             if ((entitySignature & systemSignature) == systemSignature)
             {
-                system->mEntities.insert(entity);
+                if (system->mEntities.insert(entity).second)
+                    system->mVersion++;
             }
             else
             {
-                system->mEntities.erase(entity);
+                if (system->mEntities.erase(entity))
+                    system->mVersion++;
             }
         }
     }
 
 private:
-    std::unordered_map<const char *, Signature> mSignatures{};
+    struct ScheduledJob
+    {
+        System *system;
+        std::function<void()> run;
+    };
 
     std::unordered_map<const char *, std::shared_ptr<System>> mSystems{};
+
+    struct JobGraph
+    {
+        std::vector<ScheduledJob> jobs;
+        std::vector<std::vector<size_t>> dependents;
+        std::unique_ptr<std::atomic<uint32_t>[]> remaining;
+        std::atomic<uint32_t> pending{0};
+
+        std::mutex mainThreadMutex;
+        std::vector<size_t> mainThreadReady; // main thread jobs whose dependencies are done
+    };
+
+    std::vector<ScheduledJob> mScheduled{};
+
+    ThreadPool mThreadPool{0};
+
+    void SubmitJob(std::shared_ptr<JobGraph> graph, size_t index)
+    {
+        if (graph->jobs[index].system->mMainThread)
+        {
+            std::lock_guard<std::mutex> lock(graph->mainThreadMutex);
+            graph->mainThreadReady.push_back(index);
+            return;
+        }
+
+        mThreadPool.Submit([this, graph, index]
+                           { RunJob(graph, index); });
+    }
+
+    void RunJob(const std::shared_ptr<JobGraph> &graph, size_t index)
+    {
+        graph->jobs[index].run();
+
+        for (size_t dependent : graph->dependents[index])
+        {
+            if (--graph->remaining[dependent] == 0)
+                SubmitJob(graph, dependent);
+        }
+
+        --graph->pending;
+    }
+
+    static bool PopMainThreadJob(JobGraph &graph, size_t &index)
+    {
+        std::lock_guard<std::mutex> lock(graph.mainThreadMutex);
+        if (graph.mainThreadReady.empty())
+            return false;
+
+        index = graph.mainThreadReady.back();
+        graph.mainThreadReady.pop_back();
+        return true;
+    }
+
+    static bool Conflicts(const System &a, const System &b)
+    {
+        // systems without declared access are treated as touching everything
+        if ((a.mReads | a.mWrites).none() || (b.mReads | b.mWrites).none())
+            return true;
+
+        return (a.mWrites & (b.mReads | b.mWrites)).any() || (b.mWrites & a.mReads).any();
+    }
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "coordinator.hpp"
+#include "types.hpp"
+#include "components.hpp"
+
+// Caches local and world matrices for every entity with a TransformComponent.
+// Entities are kept in contiguous arrays sorted so parents always come before their children,
+// which lets the world matrices be rebuilt in one linear pass that only touches changed subtrees.
+// Transforms are compared against the cached values each update, so editing a TransformComponent
+// in place is picked up automatically. Changing a Parent value in place needs MarkHierarchyDirty().
+// Entities joining or leaving are patched into the arrays, only changes to the hierarchy re-sort them.
+class TransformSystem : public System
+{
+public:
+    std::shared_ptr<Coordinator> gCoordinator;
+
+    void Init(std::shared_ptr<Coordinator> coordinator);
+    void Update();
+
+    // forces the local matrix of entity to be rebuilt on the next update
+    void MarkDirty(Entity entity);
+
+    // forces the parent order to be rebuilt on the next update
+    void MarkHierarchyDirty();
+
+    // world matrix from the last update, identity for entities the system has not seen yet
+    const glm::mat4 &GetWorldMatrix(Entity entity) const;
+
+private:
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+    // one slot per entity, in parent-before-child order
+    std::vector<Entity> mOrder;
+    std::vector<uint32_t> mParentSlot;
+    std::vector<glm::mat4> mLocal;
+    std::vector<glm::mat4> mWorld;
+    std::vector<uint8_t> mDirty;
+    std::vector<uint32_t> mChildCount;
+
+    // the transform values the local matrices were built from
+    std::vector<glm::vec3> mTranslation;
+    std::vector<glm::vec3> mRotation;
+    std::vector<glm::vec3> mScale;
+
+    std::unordered_map<Entity, uint32_t> mSlots;
+    std::unordered_set<Entity> mMissingParents; // parents of transformed entities that are not transformed themselves
+
+    uint64_t mBuiltVersion = UINT64_MAX;
+    bool mHierarchyDirty = true;
+
+    void RebuildOrder();
+    bool UpdateMembership(); // false when the change touches the hierarchy and needs RebuildOrder
+};
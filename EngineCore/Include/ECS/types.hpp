@@ -7,7 +7,12 @@
 using Entity = std::uint32_t;
 using ComponentType = std::uint8_t;
 
-const Entity MAX_ENTITIES = 25000;
+// can be raised per target, the benchmarks build with room for a million entities
+#ifndef ECS_MAX_ENTITIES
+#define ECS_MAX_ENTITIES 25000
+#endif
+
+const Entity MAX_ENTITIES = ECS_MAX_ENTITIES;
 const ComponentType MAX_COMPONENTS = 32;
 
 using Signature = std::bitset<MAX_COMPONENTS>;
\ No newline at end of file
@@ -11,4 +11,4 @@ VkRect2D makeScissor(VkExtent2D extent);
 void setViewport(VkCommandBuffer commandBuffer, VkViewport viewport);
 void setScissor(VkCommandBuffer commandBuffer, VkRect2D scissor);
 void draw(VkCommandBuffer commandBuffer, int vertexCount, int instanceCount = 1, int firstVertex = 0, int firstInstance = 1);
-void drawIndexed(VkCommandBuffer commandBuffer, int indicesCount, int instanceCount = 1, int firstVertex = 0, int firstInstance = 1);
\ No newline at end of file
+void drawIndexed(VkCommandBuffer commandBuffer, int indicesCount, int instanceCount = 1, int firstVertex = 0, int firstInstance = 0);
\ No newline at end of file
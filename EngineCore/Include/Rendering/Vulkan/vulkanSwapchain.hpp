@@ -25,11 +25,17 @@ struct SwapChainObjects
   VkImage depthImage;
   VkDeviceMemory depthImageMemory;
   VkImageView depthImageView;
+
+  std::vector<VkDeviceMemory> offscreenImageMemory; // only offscreen targets own their images, swapchain images belong to the swapchain
 };
 
 SwapChainObjects createSwapChain(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, GLFWwindow *window);
 void recreateSwapChain(VkCommandPool commandPool, VkQueue graphicsQueue, VkRenderPass renderPass, SwapChainObjects &swapChainObjects, VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, GLFWwindow *window);
 void cleanupSwapChain(SwapChainObjects &swapChainObjects, VkDevice device);
+
+// Color images standing in for a swapchain when rendering headless, without a swapchain handle. They can be
+// copied from after the render pass, the format is RGBA so copies are ready to write out as images.
+SwapChainObjects createOffscreenTarget(VkExtent2D extent, uint32_t imageCount, VkDevice device, VkPhysicalDevice physicalDevice);
 void destroySwapChain(VkSwapchainKHR swapChain, VkDevice device);
 
 VkResult acquireNextImageIndex(uint32_t &imageIndex, VkSemaphore imageAvailableSemaphore, VkSwapchainKHR swapChain, VkDevice device);
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -15,6 +16,11 @@ public:
   uint32_t allocate(uint32_t size);
   void free(uint32_t offset, uint32_t size);
 
+  // fragmentation shows up as a largest range well below the free total
+  uint32_t freeSize() const;
+  uint32_t largestFreeRange() const;
+  size_t freeRangeCount() const { return freeRanges.size(); }
+
 private:
   std::vector<FreeRange> freeRanges;
 };
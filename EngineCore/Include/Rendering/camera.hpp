@@ -130,6 +130,13 @@ public:
     updateCameraVectors();
   }
 
+  void setOrientation(float yaw, float pitch)
+  {
+    Yaw = yaw;
+    Pitch = pitch;
+    updateCameraVectors();
+  }
+
   void invertPitch()
   {
     Pitch = -Pitch;
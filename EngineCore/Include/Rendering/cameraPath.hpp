@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+#include "performanceOverlay.hpp"
+
+struct CameraPathFrame
+{
+  glm::vec3 position;
+  float yaw;
+  float pitch;
+};
+
+// Camera positions and orientations at a fixed timestep. Replaying one frame of the path per
+// rendered frame with the timestep as the frame time makes every run stream the same chunks in the
+// same order, so runs of different builds compare directly. Stored as text: a header line with the
+// timestep, then "x y z yaw pitch" per frame.
+class CameraPath
+{
+public:
+  float timestep = 1.0f / 60.0f;
+  std::vector<CameraPathFrame> frames;
+
+  bool Save(const std::string &path) const;
+  bool Load(const std::string &path);
+
+  // flies from one point to the other at speed blocks per second, looking along the line
+  static CameraPath Line(const glm::vec3 &from, const glm::vec3 &to, float speed, float timestep = 1.0f / 60.0f);
+};
+
+// Records the camera every frame, resampled onto the path's fixed timestep so the recording does not
+// depend on the frame rate it was made at.
+class CameraPathRecorder
+{
+public:
+  explicit CameraPathRecorder(float timestep = 1.0f / 60.0f);
+
+  void Record(const Camera &camera, float deltaTime);
+  const CameraPath &Path() const { return path; }
+
+private:
+  CameraPath path;
+  CameraPathFrame previous{};
+  double previousTime = 0.0;
+  double nextSampleTime = 0.0;
+  bool started = false;
+};
+
+// Per frame timings and chunk pipeline statistics of a replay, written as JSON with a summary.
+class ReplayReport
+{
+public:
+  struct Frame
+  {
+    float ms; // wall time of the whole frame
+    FrameStageTimes stages;
+    size_t loadedChunks;
+    size_t queuedChunks;
+    size_t chunksCreated;
+    size_t chunksGenerated;
+    size_t chunksMeshed;
+    size_t meshesUploaded;
+    size_t bytesUploaded;
+  };
+
+  void Add(const Frame &frame) { frames.push_back(frame); }
+  size_t FrameCount() const { return frames.size(); }
+
+  // prints the summary too
+  bool Write(const std::string &path, const std::string &cameraPath) const;
+
+private:
+  std::vector<Frame> frames;
+};
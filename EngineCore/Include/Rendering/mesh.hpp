@@ -26,6 +26,9 @@ public:
 
   void Draw();
 
+  // draws instanceCount copies, the shader reads instance firstInstance + i from the bound instance buffer
+  void DrawInstanced(uint32_t instanceCount, uint32_t firstInstance);
+
   VkBuffer GetVertexBuffer() const;
   VkBuffer GetIndexBuffer() const;
   uint32_t GetIndexCount() const;
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+#include <vulkan/vulkan.h>
+
+struct GLFWwindow;
+class Renderer;
+class VoxelSystem;
+class MeshingSystem;
+class RenderSystem;
+
+// CPU time of each main loop stage in the last frame, in milliseconds
+struct FrameStageTimes
+{
+  float input = 0.0f;
+  float voxels = 0.0f;
+  float meshing = 0.0f;
+  float transforms = 0.0f;
+  float render = 0.0f;
+};
+
+// writes the time until it goes out of scope into stage, in milliseconds
+class StageTimer
+{
+public:
+  explicit StageTimer(float &stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+  ~StageTimer() { stage = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count(); }
+
+  StageTimer(const StageTimer &) = delete;
+  StageTimer &operator=(const StageTimer &) = delete;
+
+private:
+  float &stage;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Dear ImGui window with frame times, chunk streaming and GPU memory statistics, and controls for
+// the render radii and streaming budgets so they can be tuned without rebuilding. While hidden it
+// builds and records nothing.
+class PerformanceOverlay
+{
+public:
+  bool visible = false;
+
+  void Init(Renderer &renderer, GLFWwindow *window); // after the renderer, ImGui allocates from its descriptor pool
+  void Cleanup();                                    // before the renderer, with the device idle
+
+  void AddFrameTime(float ms);
+
+  // builds this frame's window, call once per frame before the render system records it
+  void Build(Renderer &renderer, VoxelSystem &voxelSystem, const MeshingSystem &meshingSystem, const RenderSystem &renderSystem, const FrameStageTimes &stages);
+  void Record(VkCommandBuffer commandBuffer); // inside the render pass
+
+  bool WantsKeyboard() const; // a text field has focus, game input should ignore the keyboard
+
+private:
+  static constexpr size_t HistoryLength = 240;
+
+  std::array<float, HistoryLength> frameTimes{};
+  size_t nextFrameTime = 0;
+  bool initialized = false;
+  bool built = false;
+  VkDeviceSize deviceLocalHeap = 0;
+};
@@ -36,6 +36,7 @@ const std::vector<VkDynamicState> dynamicStates = {
 const int MAX_FRAMES_IN_FLIGHT = 2;
 
 constexpr uint32_t MAX_VERTICES = 100000000;
+constexpr uint32_t MAX_MESH_INSTANCES = 65536; // per frame, shared by every instanced mesh draw
 
 #ifdef NDEBUG
 const bool enableValidationLayers = false;
@@ -63,10 +64,14 @@ struct VoxelBuffers
   VkDeviceMemory indirectBufferMemory;
 };
 
+// Without a window the renderer runs headless: there is no surface or swapchain, frames render into
+// offscreen images of offscreenExtent on any Vulkan device, software ones like lavapipe included, and
+// are never presented.
 class Renderer
 {
 public:
   GLFWwindow *window;
+  VkExtent2D offscreenExtent = {800, 600}; // set before init
   VkInstance instance;
   VkSurfaceKHR surface;
   VkPhysicalDevice physicalDevice;
@@ -99,8 +104,13 @@ public:
 
   VoxelBuffers voxelBuffers;
 
+  std::vector<VkBuffer> instanceBuffers; // used for mesh instance model matrices, one per frame in flight
+  std::vector<VkDeviceMemory> instanceBuffersMemory;
+  std::vector<void *> instanceBuffersMapped;
+
   std::vector<VkDescriptorSet> cameraSets;
   VkDescriptorSet voxelSet;
+  std::vector<VkDescriptorSet> instanceSets;
 
   std::vector<VkSemaphore> imageAvailableSemaphores;
   std::vector<VkSemaphore> renderFinishedSemaphores;
@@ -127,6 +137,18 @@ public:
 
   void createDescriptorSets();
 
+  // Headless only. Writes the frame started next, or the one being recorded, to a PNG once the GPU has
+  // rendered it. Waits for that frame, so captured frames take longer than the others.
+  void captureFrame(const std::string &path);
+
 private:
   uint32_t imageIndex;
+
+  VkBuffer captureBuffer = VK_NULL_HANDLE; // offscreen image readback, host visible
+  VkDeviceMemory captureBufferMemory = VK_NULL_HANDLE;
+  void *captureBufferMapped = nullptr;
+  std::string capturePath;
+
+  void endOffscreenFrame();
+  void writeCapture();
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+// Frame times in fixed 0.1 ms buckets, so adding a frame never allocates. Percentiles are accurate
+// to a bucket, frames over the last bucket are counted in it and the max is kept exactly.
+class FrameTimeHistogram
+{
+public:
+  static constexpr double BucketMs = 0.1;
+  static constexpr size_t BucketCount = 2000;
+
+  void Add(double ms);
+  void Reset();
+
+  double Percentile(double p) const; // p in [0, 1], in milliseconds
+  double Max() const { return max; }
+  uint64_t Count() const { return count; }
+
+private:
+  std::array<uint32_t, BucketCount> buckets{};
+  uint64_t count = 0;
+  double max = 0.0;
+};
+
+// Keeps the profiler recording as a flight recorder and, when a frame takes longer than the
+// threshold, writes a Chrome trace of the frames around it once framesAround more frames have run.
+// Slow frames inside a window that is still waiting to be written end up in the same trace, and the
+// frame that writes a trace is left out of the histogram so the write does not trigger another one.
+class StutterDetector
+{
+public:
+  double thresholdMs = 50.0;
+  int framesAround = 30;
+  int maxTraces = 20; // stop writing traces after this many, stutters are still counted
+  std::string directory = "Stutters";
+
+  void Start(); // starts the profiler, which has to keep recording for the frames before a stutter
+  void FrameBoundary(); // once per frame at the same point in the loop, also marks the frame for the profiler
+
+  // Writes everything the profiler still has, for captures on demand. Call it between frames.
+  bool WriteRecent(const std::string &path);
+
+  FrameTimeHistogram &Histogram() { return histogram; }
+  uint64_t Stutters() const { return stutters; }
+
+private:
+  struct PendingTrace
+  {
+    uint64_t frame;
+    double ms;
+    uint64_t from;
+    uint64_t firstFrame;
+    uint64_t lastFrame;
+  };
+
+  void WriteTrace(const PendingTrace &trace, uint64_t to);
+
+  FrameTimeHistogram histogram;
+  std::deque<uint64_t> frameStarts; // starts of the last framesAround + 1 frames, the newest is the current one
+  uint64_t frame = 0;
+  uint64_t lastBoundary = 0;
+  bool skipFrame = false;
+  bool pending = false;
+  PendingTrace pendingTrace{};
+  uint64_t stutters = 0;
+  int tracesWritten = 0;
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Each worker owns a deque: it pushes and pops work at the back
+// (newest first, cache friendly) and idle workers steal from the front of other deques.
+// A thread count of 0 runs every task inline on the submitting thread, which gives a fully
+// deterministic, single-threaded execution order for debugging.
+class ThreadPool
+{
+public:
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(unsigned int threadCount = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // stops the current workers and starts threadCount new ones, must not be called while work is in flight
+  void SetThreadCount(unsigned int threadCount);
+  unsigned int GetThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+  bool IsSingleThreaded() const { return workers.empty(); }
+
+  void Submit(Task task);
+
+  // runs queued tasks on the calling thread until pending reaches 0
+  void Wait(const std::atomic<uint32_t> &pending);
+  // runs one queued task on the calling thread, false when there was none
+  bool RunTask();
+
+  // splits [0, count) into slices of at most grainSize and runs fn(begin, end) for each slice, returns once all slices are done
+  void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &fn);
+
+  // 0 for threads that are not owned by the pool (the main thread), 1..threadCount for workers
+  static unsigned int CurrentThreadIndex();
+
+private:
+  struct WorkQueue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkQueue>> queues; // queues[0] is shared by external threads
+  std::vector<std::thread> workers;
+
+  std::atomic<bool> running{false};
+  std::atomic<uint32_t> queuedTasks{0};
+  std::mutex sleepMutex;
+  std::condition_variable wakeCondition;
+
+  void Start(unsigned int threadCount);
+  void Stop();
+  void WorkerLoop(unsigned int index);
+  bool TryRunTask(unsigned int index);
+  bool PopLocal(unsigned int index, Task &task);
+  bool Steal(unsigned int index, Task &task);
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Nearest neighbour lookup over biome feature points (elevation, erosion, continentalness,
+// weirdness, temperature, humidity). The unit feature cube is cut into a 6D grid and every cell
+// keeps the few biomes that can be nearest to some point inside it, so a query only measures
+// those instead of every biome. Distances are summed in the same order as the linear scan and ties
+// go to the lowest id, so both return the same biome for every query.
+class BiomeIndex
+{
+public:
+  static constexpr int Dimensions = 6;
+  using Point = std::array<float, Dimensions>;
+
+  // ids are the positions in points. Building measures every biome against every cell, so call it
+  // once after all biomes are known rather than per biome.
+  void Build(const std::vector<Point> &points, int resolution = 6);
+
+  // id of the closest point, or -1 when the index is empty
+  int Nearest(const Point &query) const;
+
+  // plain scan over every point, the reference Nearest is checked against
+  int NearestLinear(const Point &query) const;
+
+  size_t Size() const { return count; }
+
+  // average biomes a cell query measures, count when there is no grid
+  float AverageCandidates() const;
+
+private:
+  // below this many biomes the scan is cheaper than finding the cell
+  static constexpr size_t MinGridBiomes = 32;
+
+  float Distance(uint32_t id, const Point &query) const;
+
+  // coordinates by axis, indexed by id
+  std::array<std::vector<float>, Dimensions> coords;
+  size_t count = 0;
+
+  int resolution = 0;
+  std::vector<uint32_t> cellStart;
+  std::vector<uint16_t> cellCandidates;
+};
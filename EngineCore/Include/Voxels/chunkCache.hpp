@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Voxels/components.hpp"
+
+// Holds the voxel data of recently unloaded chunks, compressed with EncodeVoxels, so a chunk the player walks
+// back to is restored instead of generated again. Entries are evicted least recently stored first
+// once the encoded data passes the memory budget. Safe to use from the generation worker threads.
+class ChunkCache
+{
+public:
+  explicit ChunkCache(size_t budgetBytes = 64 * 1024 * 1024) : budget(budgetBytes) {}
+
+  // 0 disables the cache
+  void SetBudget(size_t bytes);
+  size_t GetBudget() const { return budget; }
+
+  // replaces any entry already stored for coord
+  void Store(const glm::ivec3 &coord, int lod, const std::vector<Voxel> &voxels);
+
+  // Decodes the entry for coord into voxels and drops it from the cache. Only entries at maxLod or
+  // finer are returned, their lod is written to lod so the caller can resample. Counts a hit or miss.
+  bool Take(const glm::ivec3 &coord, int maxLod, std::vector<Voxel> &voxels, int &lod);
+
+  void Erase(const glm::ivec3 &coord);
+  void Clear();
+
+  size_t Size();
+  size_t MemoryUsage(); // bytes of encoded voxel data
+  uint64_t Hits();
+  uint64_t Misses();
+  float HitRate(); // hits over lookups, 0 before the first lookup
+
+private:
+  struct Entry
+  {
+    glm::ivec3 coord;
+    int lod;
+    std::vector<uint8_t> data;
+
+    size_t Bytes() const { return data.size(); }
+  };
+
+  void EraseLocked(const glm::ivec3 &coord);
+  void EvictLocked();
+
+  std::mutex mutex;
+  size_t budget;
+  size_t usage = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+
+  std::list<Entry> entries; // most recently stored first
+  std::unordered_map<glm::ivec3, std::list<Entry>::iterator, IVec3Hash> lookup;
+};
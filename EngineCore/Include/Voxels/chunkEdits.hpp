@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "voxel.hpp"
+
+// The voxels the player changed in one chunk, as full resolution voxelData indices sorted ascending
+// with the block each was set to. A chunk is its generated data with these applied on top, so only
+// the edits need to be saved.
+class ChunkEdits
+{
+public:
+  struct Edit
+  {
+    uint16_t index;
+    uint32_t type;
+  };
+
+  // replaces an earlier edit of the same voxel
+  void Set(uint16_t index, uint32_t type);
+
+  // Writes the edits that land on the lod's sample lattice into voxels, which holds the chunk's data
+  // at that lod.
+  void Apply(std::vector<Voxel> &voxels, int lod) const;
+
+  bool Empty() const { return edits.empty(); }
+  size_t Size() const { return edits.size(); }
+  const std::vector<Edit> &Edits() const { return edits; }
+
+  // indices are stored as gaps from the previous one, so clustered edits take a couple of bytes each
+  void Encode(std::vector<uint8_t> &out) const;
+  bool Decode(const uint8_t *data, size_t size); // false if the data is malformed
+
+private:
+  std::vector<Edit> edits;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <functional>
+
+#include "Voxels/components.hpp"
+
+// Caches per-column generation data keyed by chunk (x, z) so every chunk stacked in that column
+// shares one copy. Columns are reference counted by the chunks loaded in them and evicted when
+// the last one unloads. Safe to use from the generation worker threads.
+template <typename Column>
+class ColumnCache
+{
+public:
+    // a chunk in this column was loaded
+    void Retain(const glm::ivec2 &column)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &entry = entries[column];
+        if (!entry)
+            entry = std::make_shared<Entry>();
+        entry->refCount++;
+    }
+
+    // a chunk in this column was unloaded, the column is dropped once none are left
+    void Release(const glm::ivec2 &column)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(column);
+        if (it == entries.end())
+            return;
+
+        if (--it->second->refCount == 0)
+            entries.erase(it);
+    }
+
+    // Returns the column, computing it with build the first time. Threads asking for a column that is
+    // still being built wait for it instead of building it again. Columns that were never retained are
+    // built but not cached.
+    std::shared_ptr<const Column> Get(const glm::ivec2 &column, const std::function<void(const glm::ivec2 &, Column &)> &build)
+    {
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(column);
+            if (it != entries.end())
+                entry = it->second;
+        }
+
+        if (!entry)
+        {
+            auto uncached = std::make_shared<Column>();
+            build(column, *uncached);
+            return uncached;
+        }
+
+        std::call_once(entry->built, [&]
+                       {
+                           entry->data = std::make_shared<Column>();
+                           build(column, *entry->data); });
+
+        return entry->data;
+    }
+
+    size_t Size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t refCount = 0;
+        std::once_flag built;
+        std::shared_ptr<Column> data;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<glm::ivec2, std::shared_ptr<Entry>, IVec2Hash> entries;
+};
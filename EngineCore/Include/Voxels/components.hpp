@@ -12,8 +12,6 @@
 
 class VoxelMesh;
 
-#define CHUNK_SIZE 31
-
 struct IVec3Hash
 {
     std::size_t operator()(const glm::ivec3 &v) const noexcept
@@ -25,6 +23,16 @@ struct IVec3Hash
     }
 };
 
+struct IVec2Hash
+{
+    std::size_t operator()(const glm::ivec2 &v) const noexcept
+    {
+        std::size_t h1 = std::hash<int>{}(v.x);
+        std::size_t h2 = std::hash<int>{}(v.y);
+        return h1 ^ (h2 << 1);
+    }
+};
+
 enum class ChunkState
 {
     Clean,
@@ -53,6 +61,17 @@ struct ChunkComponent // turns an entity into a voxel chunk
 
     uint32_t gpuIndex = -1; // used for indexing into storage buffer for model matrix
 
+    // voxelData only holds the samples chunkLOD needs, Resolution()^3 voxels every Step() blocks apart
+    int Step() const
+    {
+        return 1 << chunkLOD;
+    }
+
+    int Resolution() const
+    {
+        return CHUNK_SIZE / Step();
+    }
+
     ChunkComponent()
     {
     }
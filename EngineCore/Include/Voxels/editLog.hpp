@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+#include "Voxels/components.hpp"
+#include "chunkEdits.hpp"
+
+// Append only file of chunk edit deltas. A save appends one record per chunk that changed since the
+// last one and the latest record for a chunk wins, so the file only grows with what the player did
+// and saving never rewrites anything.
+class EditLog
+{
+public:
+  EditLog() = default;
+  ~EditLog();
+  EditLog(const EditLog &) = delete;
+  EditLog &operator=(const EditLog &) = delete;
+
+  // Reads the latest edits of every chunk in the file into edits, creating the file if it is missing.
+  // When most of the file is superseded records, or it ends in a record cut off by a crash, it is
+  // rewritten with only the latest ones.
+  bool Open(const std::string &path, std::unordered_map<glm::ivec3, ChunkEdits, IVec3Hash> &edits);
+  void Close();
+  bool IsOpen() const { return file != nullptr; }
+
+  bool Append(const glm::ivec3 &coord, const ChunkEdits &edits);
+
+  uint64_t FileSize() const { return fileSize; }
+
+private:
+  static constexpr uint32_t Magic = 0x44455856; // "VXED"
+  static constexpr uint32_t Version = 1;
+
+  struct RecordHeader
+  {
+    int32_t x, y, z;
+    uint32_t length;
+  };
+
+  bool Rewrite(const std::unordered_map<glm::ivec3, ChunkEdits, IVec3Hash> &edits);
+
+  std::string path;
+  std::FILE *file = nullptr;
+  uint64_t fileSize = 0;
+};
@@ -18,6 +18,7 @@ public:
 
   MeshingSystem(WorldComponent &world) : world(world)
   {
+    mMainThread = true; // uploads go through the renderer's graphics queue
   }
 
   void Init(std::shared_ptr<Coordinator> coordinator);
@@ -25,6 +26,21 @@ public:
 
   void CreateMesh(Texture voxelTextures, Renderer &renderer, Entity chunk);
 
+  // CPU side greedy meshing, safe to call from worker threads
+  void BuildMesh(Entity chunk, std::vector<VoxelVertex> &vertices, std::vector<uint32_t> &indices);
+  // GPU upload and component updates, main thread only
+  void UploadMesh(Texture voxelTextures, Renderer &renderer, Entity chunk, const std::vector<VoxelVertex> &vertices, const std::vector<uint32_t> &indices);
+
+  // what the last Update did, waiting chunks need meshing but still hold data from another lod
+  struct Stats
+  {
+    size_t meshed = 0;
+    size_t uploaded = 0;
+    size_t uploadedBytes = 0;
+    size_t waiting = 0;
+  };
+  Stats stats;
+
 private:
   WorldComponent &world;
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+
+#include "FastNoiseLite.h"
+
+// The FastNoiseLite settings a NoiseLayer is built from. FastNoiseLite does not expose its
+// configuration, so the batched path keeps its own copy.
+struct NoiseSettings
+{
+  int seed = 1337;
+  FastNoiseLite::NoiseType noiseType = FastNoiseLite::NoiseType_OpenSimplex2;
+  float frequency = 0.01f;
+
+  FastNoiseLite::FractalType fractalType = FastNoiseLite::FractalType_None;
+  int octaves = 3;
+  float lacunarity = 2.0f;
+  float gain = 0.5f;
+  float weightedStrength = 0.0f;
+};
+
+// One 2D noise layer that can be sampled point by point through FastNoiseLite or a whole grid at a
+// time through the SIMD path. Perlin and OpenSimplex2 with no fractal or FBm are batched and match
+// FastNoiseLite bit for bit, every other combination falls back to scalar FastNoiseLite calls.
+class NoiseLayer
+{
+public:
+  NoiseLayer() = default;
+  explicit NoiseLayer(const NoiseSettings &settings);
+
+  void Configure(const NoiseSettings &settings);
+  const NoiseSettings &GetSettings() const { return settings; }
+
+  float GetNoise(float x, float y) const { return noise.GetNoise(x, y); }
+
+  // out[i + countX * j] = GetNoise(startX + i * step, startY + j * step)
+  void FillGrid(float *out, int countX, int countY, float startX, float startY, float step = 1.0f) const;
+
+  // same as FillGrid but always uses scalar FastNoiseLite, used as the reference for validation
+  void FillGridScalar(float *out, int countX, int countY, float startX, float startY, float step = 1.0f) const;
+
+  bool IsBatched() const;
+
+  // Samples a lattice every stride blocks and bilinearly interpolates between it, for output points
+  // step blocks apart. The lattice is aligned to world coordinates so neighbouring grids share
+  // lattice points and stay seamless. Grids at least as sparse as the lattice are sampled exactly.
+  void FillGridInterpolated(float *out, int countX, int countY, int startX, int startY, int stride, int step = 1) const;
+
+  // FillGridInterpolated with the stride picked by SetSampling
+  void FillGridSampled(float *out, int countX, int countY, int startX, int startY, int step = 1) const;
+
+  // Picks the largest stride up to maxStride (halving from maxStride down) whose measured
+  // interpolation error stays within maxError, falls back to full resolution otherwise.
+  void SetSampling(int maxStride, float maxError);
+  int GetStride() const { return stride; }
+  float GetMaxError() const { return maxError; }
+
+  // largest difference between FillGridInterpolated and FillGrid over a fixed set of test grids
+  float MeasureInterpolationError(int stride) const;
+
+private:
+  NoiseSettings settings;
+  FastNoiseLite noise;
+  float fractalBounding = 1.0f / 1.75f;
+
+  int stride = 1;
+  float maxError = 0.0f;
+};
+
+// name of the lane width FillGrid was compiled with: "avx2", "sse" or "scalar"
+const char *NoiseBatchPath();
@@ -0,0 +1,135 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "voxel.hpp"
+
+// Read only view of a whole file, mapped into memory.
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const uint8_t *Data() const { return data; }
+  size_t Size() const { return size; }
+
+private:
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  void *file = nullptr;
+  void *mapping = nullptr;
+#endif
+};
+
+// Saves chunks to disk, RegionSize^3 chunks per region file. A region file starts with a table of
+// offset, length and lod for every chunk in it, followed by the chunks' encoded voxel data. Reads go
+// through a memory mapping of the file. Writes append the new data and then repoint the table entry,
+// so a chunk saved again leaves its old data behind as dead space and an interrupted write leaves the
+// previous copy readable. Files are written in the machine's byte order. Only the MaxCachedRegions
+// most recently used regions keep their table, file and mapping, the others are read again when
+// needed. Safe to use from the generation worker threads.
+class RegionStorage
+{
+public:
+  static constexpr int RegionSize = 32;
+  static constexpr size_t MaxCachedRegions = 64; // each keeps a 512 KiB table
+
+  RegionStorage() = default;
+  ~RegionStorage();
+  RegionStorage(const RegionStorage &) = delete;
+  RegionStorage &operator=(const RegionStorage &) = delete;
+
+  // creates the directory if needed, false if it cannot be used
+  bool Open(const std::string &directory);
+  void Close();
+  bool IsOpen() const { return open; }
+
+  // Reads the chunk if it was saved at maxLod or finer, lod gets the lod it was saved at
+  bool Read(int x, int y, int z, int maxLod, std::vector<Voxel> &voxels, int &lod);
+
+  // true if the chunk is saved at lod or finer
+  bool Contains(int x, int y, int z, int lod);
+
+  // Appends the chunk to its region file. Data at a coarser lod than what is already saved is dropped
+  // so a demoted chunk never replaces its full resolution copy.
+  bool Write(int x, int y, int z, int lod, const std::vector<Voxel> &voxels) { return Write(x, y, z, lod, voxels.data(), voxels.size()); }
+  bool Write(int x, int y, int z, int lod, const Voxel *voxels, size_t count);
+
+  uint64_t BytesRead();
+  uint64_t BytesWritten();
+
+private:
+  static constexpr uint32_t Magic = 0x47525856; // "VXRG"
+  static constexpr uint32_t Version = 2;
+  static constexpr int ChunksPerRegion = RegionSize * RegionSize * RegionSize;
+
+  struct Entry
+  {
+    uint64_t offset = 0; // 0 when the chunk was never saved
+    uint32_t length = 0;
+    uint8_t lod = 0;
+    uint8_t padding[3] = {};
+  };
+
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t version;
+  };
+
+  static constexpr size_t DataStart = sizeof(Header) + sizeof(Entry) * ChunksPerRegion;
+
+  struct Region
+  {
+    std::string path;
+    std::vector<Entry> entries;
+    std::FILE *file = nullptr;          // opened for writing on the first write
+    std::shared_ptr<MappedFile> mapped; // remapped when a read needs data past its end
+    uint64_t fileSize = 0;              // 0 until the file exists
+    bool valid = true;                  // false when the file on disk could not be read
+    uint64_t lastUse = 0;
+
+    ~Region()
+    {
+      if (file)
+        std::fclose(file);
+    }
+  };
+
+  struct RegionKey
+  {
+    int x, y, z;
+    bool operator==(const RegionKey &other) const { return x == other.x && y == other.y && z == other.z; }
+  };
+
+  struct RegionKeyHash
+  {
+    size_t operator()(const RegionKey &key) const noexcept
+    {
+      return std::hash<int>{}(key.x) ^ (std::hash<int>{}(key.y) << 1) ^ (std::hash<int>{}(key.z) << 2);
+    }
+  };
+
+  // region the chunk is in and its index in the region's table, the table is read on first use
+  Region *GetRegionLocked(int x, int y, int z, int &index);
+
+  std::mutex mutex;
+  bool open = false;
+  std::string directory;
+  std::unordered_map<RegionKey, std::unique_ptr<Region>, RegionKeyHash> regions;
+  uint64_t useCounter = 0;
+
+  uint64_t bytesRead = 0;
+  uint64_t bytesWritten = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Voxels/components.hpp"
+#include "regionStorage.hpp"
+
+// Writes a snapshot of chunks to region storage on a background thread. Starting a save copies
+// nothing, the snapshot points at the chunks' live voxel data. Until the save finishes, whoever is
+// about to change a chunk's data calls Preserve and whoever is about to replace or free it calls
+// Release, so the chunk is copied or handed over as it was when the save started. Only the chunks
+// that change while the save runs are ever copied.
+class SnapshotWriter
+{
+public:
+  struct Chunk
+  {
+    glm::ivec3 coord;
+    int lod;
+    const Voxel *voxels;
+    size_t count;
+  };
+
+  SnapshotWriter() = default;
+  ~SnapshotWriter();
+  SnapshotWriter(const SnapshotWriter &) = delete;
+  SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+  // false while the previous save is still being written
+  bool Start(RegionStorage &storage, std::vector<Chunk> chunks);
+  bool InProgress() const { return inProgress; }
+  void Wait();
+
+  // copies the chunk's data into the snapshot if the save has not written it yet
+  void Preserve(const glm::ivec3 &coord, const std::vector<Voxel> &voxels);
+
+  // Moves the chunk's data into the snapshot if the save has not written or copied it yet. True if
+  // the save still has the chunk to write, whether it took voxels or already had a copy.
+  bool Release(const glm::ivec3 &coord, std::vector<Voxel> &voxels);
+
+  uint64_t ChunksWritten();
+  uint64_t ChunksCopied(); // chunks Preserve or Release had to keep for the save
+
+private:
+  struct Entry
+  {
+    Chunk chunk;
+    std::vector<Voxel> copy;
+    bool copied = false;
+    bool written = false;
+  };
+
+  static constexpr size_t None = (size_t)-1;
+
+  void Run(RegionStorage *storage);
+  Entry *PendingLocked(const glm::ivec3 &coord, std::unique_lock<std::mutex> &lock); // waits out a write of the chunk in progress
+
+  std::thread thread;
+  std::atomic<bool> inProgress{false};
+  std::mutex mutex;
+  std::condition_variable chunkWritten;
+
+  std::vector<Entry> entries;
+  std::unordered_map<glm::ivec3, size_t, IVec3Hash> lookup;
+  size_t writing = None; // the entry the thread is encoding straight from the live data
+  uint64_t written = 0;
+  uint64_t copied = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "voxel.hpp"
+
+struct WorldFeatures
+{
+  float elevation;       // mountains vs oceans
+  float erosion;         // smooth vs sharp
+  float continentalness; // landmass vs sea
+  float weirdness;       // noise warp / chaos
+  float temperature;     // climate
+  float humidity;        // moisture
+};
+
+struct Biome
+{
+  uint16_t airBlock;
+  uint16_t topBlock;
+  uint16_t fillerBlock;
+  uint16_t stoneBlock;
+  uint16_t waterBlock;
+  uint16_t bottomBlock;
+
+  uint8_t topDepth;
+  uint8_t fillerDepth;
+
+  WorldFeatures worldFeatures;
+};
+
+// Block at worldY in a column whose terrain surface is at height. This is the per voxel rule
+// FillTerrainColumn writes in runs, note the topBlock at waterLevel when the water is above ground.
+inline uint32_t TerrainBlockAt(const Biome &biome, int worldY, int height, int waterLevel)
+{
+  if (worldY > height && worldY > waterLevel)
+    return biome.airBlock;
+  else if (worldY > height && worldY < waterLevel)
+    return biome.waterBlock;
+
+  int depth = height - worldY;
+
+  if (depth < biome.topDepth)
+    return biome.topBlock;
+  else if (depth <= biome.topDepth + biome.fillerDepth)
+    return biome.fillerBlock;
+  else if (depth < height)
+    return biome.stoneBlock;
+
+  return biome.bottomBlock;
+}
+
+// Writes count samples of one column top down as runs of identical blocks, the same blocks
+// TerrainBlockAt gives. Sample k is at world height topY - k * step and is stored at out[k * stride].
+inline void FillTerrainColumn(Voxel *out, size_t stride, int count, int topY, int step, int height, int waterLevel, const Biome &biome)
+{
+  int filled = 0;
+
+  // extends the current run down to the last sample at or above lowestY
+  auto fillDownTo = [&](int lowestY, uint32_t type)
+  {
+    int end = lowestY > topY ? 0 : std::min(count, (topY - lowestY) / step + 1);
+    for (; filled < end; filled++)
+      out[filled * stride].type = type;
+  };
+
+  fillDownTo(std::max(height, waterLevel) + 1, biome.airBlock);
+  if (waterLevel > height)
+  {
+    fillDownTo(waterLevel, biome.topBlock);
+    fillDownTo(height + 1, biome.waterBlock);
+  }
+  fillDownTo(height - biome.topDepth + 1, biome.topBlock);
+  fillDownTo(height - biome.topDepth - biome.fillerDepth, biome.fillerBlock);
+  fillDownTo(1, biome.stoneBlock);
+
+  for (; filled < count; filled++)
+    out[filled * stride].type = biome.bottomBlock;
+}
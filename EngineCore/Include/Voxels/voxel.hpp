@@ -3,7 +3,8 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <glm/gtc/matrix_transform.hpp>
+
+#define CHUNK_SIZE 31 // also the layout of saved chunk edits, changing it invalidates them
 
 struct BlockType
 {
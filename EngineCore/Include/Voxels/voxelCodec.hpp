@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "voxel.hpp"
+
+// Compression for chunk voxel data that leaves memory: region files, the unloaded chunk cache or
+// anything sent elsewhere. The block types in the chunk go into a palette, voxels are written as runs
+// of one palette entry, and the run stream is LZ compressed when that makes it smaller, since surface
+// chunks repeat the same runs layer after layer. Numbers are little endian base 128 varints.
+void EncodeVoxels(const std::vector<Voxel> &voxels, std::vector<uint8_t> &out);
+void EncodeVoxels(const Voxel *voxels, size_t count, std::vector<uint8_t> &out);
+
+// false if the data is truncated or does not decode to the voxel count it starts with
+bool DecodeVoxels(const uint8_t *data, size_t size, std::vector<Voxel> &voxels);
+
+void WriteVarint(std::vector<uint8_t> &out, uint64_t value);
+bool ReadVarint(const uint8_t *&data, const uint8_t *end, uint64_t &value); // advances data, false when it runs past end
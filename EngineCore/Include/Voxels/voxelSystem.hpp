@@ -1,18 +1,34 @@
 #pragma once
+#include <array>
 #include <memory>
 #include <utility>
 #include <functional>
+#include <vector>
+#include <unordered_set>
+#include <mutex>
+#include <string>
 
 #include "coordinator.hpp"
 #include "types.hpp"
 #include "Voxels/components.hpp"
-#include "camera.hpp"
+#include "Voxels/chunkCache.hpp"
+#include "Voxels/regionStorage.hpp"
+#include "Voxels/editLog.hpp"
+#include "Voxels/snapshotWriter.hpp"
 #include "ECS/components.hpp"
-#include "mesh.hpp"
 
 #include "FastNoiseLite.h"
 
 constexpr uint32_t MAX_CHUNKS = 32768;
+constexpr int CHUNK_LOD_COUNT = 5;
+
+// a chunk waiting to be generated, lower priority goes first
+struct ChunkRequest
+{
+    glm::ivec3 coord;
+    int lod;
+    float priority;
+};
 
 class VoxelSystem : public System
 {
@@ -23,23 +39,117 @@ public:
     {
     }
     void Init(std::shared_ptr<Coordinator> coordinator);
-    void Update(float deltaTime, const glm::vec3 &playerPos);
+    void Update(float deltaTime, const glm::vec3 &playerPos, const glm::vec3 &viewDirection);
+
+    size_t chunksPerUpdate = 64;     // chunks generated per Update, the rest stay queued
+    float lodPriorityBias = 2.0f;    // added per lod level, in chunks of distance
+    int lodHysteresis = 1;           // chunks past a lod's render radius before a chunk is demoted from it
+    size_t QueuedChunkCount() const { return requestQueue.size(); }
+    void RescanRenderRadii() { hasQueuedAround = false; } // call after changing world's render radii, the next Update rechecks every chunk
+
+    // what the last Update did, created chunks include the ones restored from the cache or storage
+    struct Stats
+    {
+        size_t created = 0;
+        size_t generated = 0;
+    };
+    Stats stats;
+    std::array<size_t, CHUNK_LOD_COUNT> LoadedChunksPerLOD() const; // walks chunkMap, for debug displays
+    size_t VoxelMemoryBytes() const;                                // voxel data held by the loaded chunks, walks chunkMap
+
+    ChunkCache chunkCache; // unloaded chunks are kept here and restored instead of generated when they come back in range
+
+    // SetVoxel records edits as per chunk deltas over the generated data. They are applied whenever
+    // a chunk is generated or loaded, so a save only holds the deltas and grows with what the player
+    // changed. With persistGeneratedChunks whole chunks are saved to regionStorage as well, and loaded
+    // from there instead of generated.
+    bool OpenSave(const std::string &directory); // edits go in directory/edits.log, chunks in directory/chunks
+    RegionStorage regionStorage;
+    EditLog editLog;
+    bool persistGeneratedChunks = false;
+    void SaveEdits(); // appends the edits made since the last save, call before shutting down
+
+    // Saves the edits, then writes every chunk generated since the last save to regionStorage on a
+    // background thread while the world keeps changing. False while the previous save is running.
+    bool SaveWorld();
+    bool SaveInProgress() const { return snapshotWriter.InProgress(); }
+    void WaitForSave();
+
+    // Generates the chunks at lod 0 across the worker threads and writes them to regionStorage without
+    // keeping them loaded, for building worlds ahead of time. Chunks that are loaded or already stored
+    // are skipped. Pass whole columns so their chunks share the column data. Returns the chunks generated.
+    size_t PregenerateChunks(const std::vector<glm::ivec3> &coords);
 
     WorldComponent &world;
 
-    void UnloadDistantChunks(const glm::ivec3 &playerChunk);
+    void UnloadDistantChunks(const glm::ivec3 &playerChunk); // scans all of chunkMap, Update only does this when the radii change
+    void UnloadChunk(const glm::ivec3 &chunkPos);
     bool ChunkExists(const glm::ivec3 &coord);
     void CreateChunk(const glm::ivec3 &coord, int lod);
+    Entity SpawnChunk(const glm::ivec3 &coord, int lod); // creates the chunk entity without generating its voxel data
+
+    // Moves a loaded chunk to another lod. Coarser lods are resampled from the data already there,
+    // finer ones need samples that were never generated so the chunk is regenerated in the next Update.
+    // The chunk keeps its old mesh until the new lod is meshed, meshing skips it while its data is stale.
+    void SetChunkLOD(const glm::ivec3 &coord, int lod);
 
-    ChunkComponent &StartGeneratingVoxelData(Entity chunk);
-    virtual void GenerateVoxelData(Entity chunk) = 0; // World Generation Logic
+    ChunkComponent &StartGeneratingVoxelData(Entity chunk); // sizes voxelData for the chunk's lod
+    bool RestoreCachedVoxelData(Entity chunk);              // false when chunkCache has nothing for it, called from worker threads
+    bool LoadStoredVoxelData(Entity chunk);                 // false when regionStorage has nothing for it, called from worker threads
+    void ApplyEdits(Entity chunk);                          // called from worker threads after the chunk's data is generated or loaded
+    void SaveChunk(Entity chunk);
+    static std::vector<Voxel> ResampleVoxels(const std::vector<Voxel> &voxels, int oldLod, int lod); // lod must be coarser than oldLod
+    virtual void GenerateVoxelData(Entity chunk) = 0; // World Generation Logic, called from worker threads so it must only touch the given chunk
+
+    // called on the voxel system thread when a chunk enters or leaves chunkMap, generators use these to manage shared per-column data
+    virtual void ChunkSpawned(const glm::ivec3 &coord, int lod) {}
+    virtual void ChunkUnloaded(const glm::ivec3 &coord, int lod) {}
+    virtual void ChunkLODChanged(const glm::ivec3 &coord, int oldLod, int newLod) {}
 
     glm::ivec3 WorldToChunk(const glm::vec3 &pos) const;
     glm::ivec3 WorldToLocal(const glm::ivec3 &worldPos) const;
     int getIndex(int x, int y, int z);
+    int getIndex(int x, int y, int z, int lod); // x, y, z are chunk local voxels on the lod's sample lattice
     Voxel &GetVoxel(const glm::ivec3 &worldPos);
     void SetVoxel(const glm::ivec3 &pos, uint32_t blockId);
     void MarkChunkDirty(const glm::ivec3 &chunkPos);
     bool IsBorderVoxel(const glm::ivec3 &worldPos) const;
     void MarkNeighborChunksDirty(const glm::ivec3 &worldPos);
+
+private:
+    // Missing chunks are queued when the player enters a new chunk and generated closest first, with
+    // chunks in view ahead of the ones behind. Requests that leave the render radius are dropped
+    // before anything is spawned for them. Crossing a chunk boundary only walks the shells of the
+    // load and unload boxes that were entered or left.
+    std::vector<ChunkRequest> requestQueue; // heap ordered by CompareRequests
+    std::unordered_set<glm::ivec3, IVec3Hash> queuedChunks;
+    glm::ivec3 queuedAroundChunk{0};
+    glm::ivec3 queuedLoadRadius{0};
+    glm::ivec3 queuedUnloadRadius{0};
+    bool hasQueuedAround = false;
+
+    static bool CompareRequests(const ChunkRequest &a, const ChunkRequest &b) { return a.priority > b.priority; }
+    glm::ivec3 RenderRadius(int lod) const;
+    int DesiredLOD(const glm::ivec3 &offset) const; // -1 outside every render radius
+    int TargetLOD(const glm::ivec3 &offset, int currentLod) const; // DesiredLOD with hysteresis on demotion
+    void UpdateChunkLOD(const glm::ivec3 &playerChunk, const glm::ivec3 &coord);
+    void UpdateAllChunkLODs(const glm::ivec3 &playerChunk);
+    void UpdateChunkLODsAround(const glm::ivec3 &oldPlayerChunk, const glm::ivec3 &playerChunk);
+    glm::ivec3 LoadRadius() const;   // the largest render radius
+    glm::ivec3 UnloadRadius() const; // renderRadius4 with some padding so chunks on the edge are not reloaded right away
+    void QueueMissingChunks(const glm::ivec3 &playerChunk);
+    void QueueEnteringChunks(const glm::ivec3 &oldPlayerChunk, const glm::ivec3 &playerChunk);
+    void QueueChunk(const glm::ivec3 &playerChunk, const glm::ivec3 &coord);
+    void UnloadLeavingChunks(const glm::ivec3 &oldPlayerChunk, const glm::ivec3 &playerChunk);
+    void RescoreRequests(const glm::ivec3 &playerChunk, const glm::vec3 &viewDirection);
+    void QueueRegeneration(const glm::ivec3 &coord, int lod); // promoted to a finer lod, generated ahead of new chunks
+
+    std::mutex editMutex;
+    std::unordered_map<glm::ivec3, ChunkEdits, IVec3Hash> edits; // every edited chunk, including the ones read from the save
+    std::unordered_set<glm::ivec3, IVec3Hash> unsavedEdits;
+    void SaveEditsLocked(const glm::ivec3 &coord);
+
+    // chunks SetVoxel changes or anything replaces or frees during a save go through snapshotWriter first
+    std::unordered_set<glm::ivec3, IVec3Hash> unsavedChunks; // generated with persistGeneratedChunks and not in regionStorage yet
+    SnapshotWriter snapshotWriter;                          // after regionStorage, so it finishes writing before the storage closes
 };
\ No newline at end of file
@@ -8,13 +8,18 @@
 #include "coordinator.hpp"
 #include "entityManager.hpp"
 #include "renderSystem.hpp"
+#include "transformSystem.hpp"
 #include "mesh.hpp"
 #include "modelLoading.hpp"
 #include "Voxels/components.hpp"
 #include "voxelSystem.hpp"
 #include "meshingSystem.hpp"
+#include "performanceOverlay.hpp"
+#include "cameraPath.hpp"
 #include "profiler.hpp"
+#include "stutterDetector.hpp"
 #include "defaultGen.hpp"
+#include "defaultWorld.hpp"
 
 class Application
 {
@@ -29,16 +34,37 @@ public:
   std::shared_ptr<Coordinator> coordinator;
   std::shared_ptr<DefaultVoxelSystem> voxelSystem;
   std::shared_ptr<MeshingSystem> meshingSystem;
+  std::shared_ptr<TransformSystem> transformSystem;
   std::shared_ptr<RenderSystem> renderSystem;
+  PerformanceOverlay performanceOverlay; // F2
 
   float lastX = 800.0f / 2.0f;
   float lastY = 600.0f / 2.0f;
   bool firstMouse = true;
 
-  Application();
-  void run();
+  int workerThreads = -1; // -1 uses all cores but one, 0 runs every system on the main thread in a fixed order
+
+  // Camera path benchmark, set before run. A replay drives the camera from the path with its fixed
+  // timestep instead of the keyboard, writes per frame timings to replayReportPath and closes the
+  // window at the end of the path.
+  std::string recordCameraPath; // records the flight to this file, written when the window closes
+  std::string replayCameraPath;
+  float flyDistance = 0.0f; // without a replay file, replays a straight flight this many blocks along +x
+  float flySpeed = 50.0f;   // blocks per second
+  std::string replayReportPath = "replay.json";
+
+  // Headless runs render offscreen at windowWidth x windowHeight without opening a window, so they work
+  // on machines without a display or GPU. They can write every captureEvery-th frame to
+  // captureDirectory/frame_<n>.png for image diffs between builds.
+  size_t frameLimit = 0; // stops after this many frames, 0 runs until the window closes or the replay ends
+  static constexpr size_t HeadlessFrameLimit = 600; // frame limit of headless runs without a replay
+  std::string captureDirectory;
+  int captureEvery = 0;
+
+  explicit Application(bool headless = false);
+  bool run(); // false when a requested replay could not start
 
 private:
-  void mainLoop();
+  bool mainLoop();
   void cleanup();
 };
@@ -1,97 +1,148 @@
 #pragma once
 #include <unordered_map>
-#include <FastNoiseLite.h>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <iostream>
 #include "Voxels/components.hpp"
 #include "voxelSystem.hpp"
-
-struct WorldFeatures
-{
-  float elevation;       // mountains vs oceans
-  float erosion;         // smooth vs sharp
-  float continentalness; // landmass vs sea
-  float weirdness;       // noise warp / chaos
-  float temperature;     // climate
-  float humidity;        // moisture
-};
-
-struct Biome
+#include "Voxels/columnCache.hpp"
+#include "Voxels/noiseGrid.hpp"
+#include "Voxels/biomeIndex.hpp"
+#include "Voxels/terrainFill.hpp"
+
+// Everything about a chunk column that does not depend on y, shared by every chunk stacked in it
+// at the same lod. Only the lod's samples are filled, indexed by sample coordinates.
+struct TerrainColumn
 {
-  uint16_t airBlock;
-  uint16_t topBlock;
-  uint16_t fillerBlock;
-  uint16_t stoneBlock;
-  uint16_t waterBlock;
-  uint16_t bottomBlock;
+  int height[CHUNK_SIZE * CHUNK_SIZE];
+  uint16_t biome[CHUNK_SIZE * CHUNK_SIZE];
+  WorldFeatures features[CHUNK_SIZE * CHUNK_SIZE];
 
-  uint8_t topDepth;
-  uint8_t fillerDepth;
+  // bounds over every sample so whole chunks above or below the surface can be filled in one go
+  int maxHeight;
+  int stoneTop;         // below this and above 0 every sample is stone
+  int32_t airBlock;     // shared by every sample's biome, -1 if they differ
+  int32_t stoneBlock;
 
-  WorldFeatures worldFeatures;
+  static int Index(int x, int z)
+  {
+    return x + CHUNK_SIZE * z;
+  }
 };
 
 class DefaultVoxelSystem : public VoxelSystem
 {
 public:
   using VoxelSystem::VoxelSystem;
-  FastNoiseLite elevation;
-  FastNoiseLite erosion;
-  FastNoiseLite continentalness;
-  FastNoiseLite weirdness;
-  FastNoiseLite temperature;
-  FastNoiseLite humidity;
-  std::unordered_map<std::string, Biome> biomes;
+  NoiseLayer elevation;
+  NoiseLayer erosion;
+  NoiseLayer continentalness;
+  NoiseLayer weirdness;
+  NoiseLayer temperature;
+  NoiseLayer humidity;
+
+  // biome ids are indices into biomes, in the order they were added
+  std::vector<Biome> biomes;
+  std::unordered_map<std::string, uint16_t> biomeNameToId;
+  BiomeIndex biomeIndex;
+
+  // one cache per lod, a column is only sampled as densely as the chunks using it need
+  std::array<ColumnCache<TerrainColumn>, CHUNK_LOD_COUNT> columnCaches;
+
+  // when set every column is also sampled at full resolution and the worst height difference the
+  // coarse sampling caused is tracked and logged
+  bool validateSampling = false;
+
+  struct SamplingValidation
+  {
+    uint64_t columns = 0;
+    float maxHeightDeviation = 0.0f;
+    float maxFeatureDeviation = 0.0f;
+  };
 
   DefaultVoxelSystem(WorldComponent &world) : VoxelSystem(world)
   {
     int seedOffsets = 1; // so seeds on different params are not correlated
-    elevation.SetSeed(world.seed);
-    elevation.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-    elevation.SetFrequency(0.004f);
-    elevation.SetFractalType(FastNoiseLite::FractalType_FBm);
-    elevation.SetFractalOctaves(4);
-    elevation.SetFractalLacunarity(4.0f);
-    elevation.SetFractalGain(0.7f);
-
-    erosion.SetSeed(world.seed + seedOffsets);
-    erosion.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-    erosion.SetFrequency(0.03f);
-
-    continentalness.SetSeed(world.seed + 2 * seedOffsets);
-    continentalness.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-    continentalness.SetFrequency(0.004f);
-    continentalness.SetFractalType(FastNoiseLite::FractalType_FBm);
-    continentalness.SetFractalOctaves(4);
-    continentalness.SetFractalLacunarity(1.5f);
-    continentalness.SetFractalGain(0.7f);
-
-    weirdness.SetSeed(world.seed + 3 * seedOffsets);
-    weirdness.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-    weirdness.SetFrequency(0.0014f);
-    weirdness.SetFractalType(FastNoiseLite::FractalType_FBm);
-    weirdness.SetFractalOctaves(8);
-    weirdness.SetFractalLacunarity(1.5f);
-    weirdness.SetFractalGain(0.9f);
-
-    temperature.SetSeed(world.seed + 4 * seedOffsets);
-    temperature.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-    temperature.SetFrequency(0.01f);
-    temperature.SetFractalType(FastNoiseLite::FractalType_FBm);
-    temperature.SetFractalOctaves(2);
-    temperature.SetFractalLacunarity(2.0f);
-    temperature.SetFractalGain(0.3f);
-
-    humidity.SetSeed(world.seed + 5 * seedOffsets);
-    humidity.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-    humidity.SetFrequency(0.017f);
-    humidity.SetFractalType(FastNoiseLite::FractalType_FBm);
-    humidity.SetFractalOctaves(2);
-    humidity.SetFractalLacunarity(2.0f);
-    humidity.SetFractalGain(0.3f);
+
+    NoiseSettings elevationSettings;
+    elevationSettings.seed = world.seed;
+    elevationSettings.noiseType = FastNoiseLite::NoiseType_Perlin;
+    elevationSettings.frequency = 0.004f;
+    elevationSettings.fractalType = FastNoiseLite::FractalType_FBm;
+    elevationSettings.octaves = 4;
+    elevationSettings.lacunarity = 4.0f;
+    elevationSettings.gain = 0.7f;
+    elevation.Configure(elevationSettings);
+
+    NoiseSettings erosionSettings;
+    erosionSettings.seed = world.seed + seedOffsets;
+    erosionSettings.noiseType = FastNoiseLite::NoiseType_OpenSimplex2;
+    erosionSettings.frequency = 0.03f;
+    erosion.Configure(erosionSettings);
+
+    NoiseSettings continentalnessSettings;
+    continentalnessSettings.seed = world.seed + 2 * seedOffsets;
+    continentalnessSettings.noiseType = FastNoiseLite::NoiseType_Perlin;
+    continentalnessSettings.frequency = 0.004f;
+    continentalnessSettings.fractalType = FastNoiseLite::FractalType_FBm;
+    continentalnessSettings.octaves = 4;
+    continentalnessSettings.lacunarity = 1.5f;
+    continentalnessSettings.gain = 0.7f;
+    continentalness.Configure(continentalnessSettings);
+
+    NoiseSettings weirdnessSettings;
+    weirdnessSettings.seed = world.seed + 3 * seedOffsets;
+    weirdnessSettings.noiseType = FastNoiseLite::NoiseType_Perlin;
+    weirdnessSettings.frequency = 0.0014f;
+    weirdnessSettings.fractalType = FastNoiseLite::FractalType_FBm;
+    weirdnessSettings.octaves = 8;
+    weirdnessSettings.lacunarity = 1.5f;
+    weirdnessSettings.gain = 0.9f;
+    weirdness.Configure(weirdnessSettings);
+
+    NoiseSettings temperatureSettings;
+    temperatureSettings.seed = world.seed + 4 * seedOffsets;
+    temperatureSettings.noiseType = FastNoiseLite::NoiseType_Perlin;
+    temperatureSettings.frequency = 0.01f;
+    temperatureSettings.fractalType = FastNoiseLite::FractalType_FBm;
+    temperatureSettings.octaves = 2;
+    temperatureSettings.lacunarity = 2.0f;
+    temperatureSettings.gain = 0.3f;
+    temperature.Configure(temperatureSettings);
+
+    NoiseSettings humiditySettings;
+    humiditySettings.seed = world.seed + 5 * seedOffsets;
+    humiditySettings.noiseType = FastNoiseLite::NoiseType_Perlin;
+    humiditySettings.frequency = 0.017f;
+    humiditySettings.fractalType = FastNoiseLite::FractalType_FBm;
+    humiditySettings.octaves = 2;
+    humiditySettings.lacunarity = 2.0f;
+    humiditySettings.gain = 0.3f;
+    humidity.Configure(humiditySettings);
+
+    // low frequency layers are sampled every few blocks and interpolated, layers that change too
+    // quickly for the error bound stay at full resolution
+    for (NoiseLayer *layer : {&elevation, &erosion, &continentalness, &weirdness, &temperature, &humidity})
+      layer->SetSampling(8, 0.01f);
   }
 
   void addBiome(Biome b, const std::string &name)
   {
-    biomes.emplace(name, b);
+    if (biomeNameToId.find(name) != biomeNameToId.end())
+      return;
+
+    biomeNameToId[name] = static_cast<uint16_t>(biomes.size());
+    biomes.push_back(b);
+
+    // the index is rebuilt on the next lookup, once all the biomes registered together are in
+    biomeIndexReady = false;
+  }
+
+  // same axis order BiomeDistance sums in, which keeps the index in agreement with it
+  static BiomeIndex::Point FeaturePoint(const WorldFeatures &f)
+  {
+    return {f.elevation, f.erosion, f.continentalness, f.weirdness, f.temperature, f.humidity};
   }
 
   float BiomeDistance(const Biome &b, const WorldFeatures &f)
@@ -106,26 +157,36 @@ public:
     return de * de + dr * dr + dc * dc + dw * dw + dt * dt + dh * dh;
   }
 
-  const Biome &chooseBiome(const WorldFeatures &features)
+  // closest biome to the features, ties go to the biome added first
+  uint16_t chooseBiomeId(const WorldFeatures &features)
   {
-    auto it = biomes.begin();
-    if (it == biomes.end())
+    if (biomes.empty())
       throw std::runtime_error("No biomes registered");
 
-    const Biome *best = &it->second;
-    float bestDist = BiomeDistance(*best, features);
+    if (!biomeIndexReady.load(std::memory_order_acquire))
+      BuildBiomeIndex();
 
-    for (auto &[_, biome] : biomes)
-    {
-      float dist = BiomeDistance(biome, features);
-      if (dist < bestDist)
-      {
-        bestDist = dist;
-        best = &biome;
-      }
-    }
+    return static_cast<uint16_t>(biomeIndex.Nearest(FeaturePoint(features)));
+  }
+
+  void BuildBiomeIndex()
+  {
+    std::lock_guard<std::mutex> lock(biomeIndexMutex);
+    if (biomeIndexReady.load(std::memory_order_relaxed))
+      return;
 
-    return *best;
+    std::vector<BiomeIndex::Point> points;
+    points.reserve(biomes.size());
+    for (const Biome &biome : biomes)
+      points.push_back(FeaturePoint(biome.worldFeatures));
+    biomeIndex.Build(points);
+
+    biomeIndexReady.store(true, std::memory_order_release);
+  }
+
+  const Biome &chooseBiome(const WorldFeatures &features)
+  {
+    return biomes[chooseBiomeId(features)];
   }
 
   WorldFeatures generateWorldFeatures(float x, float z)
@@ -142,7 +203,7 @@ public:
 
   void createVoxel(ChunkComponent &chunk, float x, float y, float z, uint32_t blockType)
   {
-    chunk.voxelData[getIndex(x, y, z)] = {blockType};
+    chunk.voxelData[getIndex(x, y, z, chunk.chunkLOD)] = {blockType};
   }
 
   float computeTerrainHeight(const WorldFeatures &features, float minHeight, float maxHeight)
@@ -163,60 +224,191 @@ public:
     return height;
   }
 
+  // fills features for a column's lod samples, either at each layer's sampling stride or at full resolution
+  void SampleColumnFeatures(const glm::ivec2 &column, int lod, WorldFeatures *features, bool fullResolution)
+  {
+    constexpr int count = CHUNK_SIZE * CHUNK_SIZE;
+    const int step = 1 << lod;
+    const int resolution = CHUNK_SIZE / step;
+    int worldBaseX = column.x * CHUNK_SIZE;
+    int worldBaseZ = column.y * CHUNK_SIZE;
+
+    // every layer is sampled for the whole column at once so the SIMD path gets full rows
+    float continentalnessGrid[count], elevationGrid[count], erosionGrid[count];
+    float humidityGrid[count], temperatureGrid[count], weirdnessGrid[count];
+
+    auto sample = [&](const NoiseLayer &layer, float *grid)
+    {
+      if (fullResolution)
+        layer.FillGrid(grid, resolution, resolution, worldBaseX, worldBaseZ, step);
+      else
+        layer.FillGridSampled(grid, resolution, resolution, worldBaseX, worldBaseZ, step);
+    };
+
+    sample(continentalness, continentalnessGrid);
+    sample(elevation, elevationGrid);
+    sample(erosion, erosionGrid);
+    sample(humidity, humidityGrid);
+    sample(temperature, temperatureGrid);
+    sample(weirdness, weirdnessGrid);
+
+    for (int z = 0; z < resolution; z++)
+    {
+      for (int x = 0; x < resolution; x++)
+      {
+        int g = x + resolution * z;
+        WorldFeatures &f = features[TerrainColumn::Index(x, z)];
+        f.continentalness = 0.5 + continentalnessGrid[g] * 0.5;
+        f.elevation = 0.5 + elevationGrid[g] * 0.5;
+        f.erosion = 0.5 + erosionGrid[g] * 0.5;
+        f.humidity = 0.5 + humidityGrid[g] * 0.5;
+        f.temperature = 0.5 + temperatureGrid[g] * 0.5;
+        f.weirdness = 0.5 + weirdnessGrid[g] * 0.5;
+      }
+    }
+  }
+
+  void BuildTerrainColumn(const glm::ivec2 &column, int lod, TerrainColumn &data)
+  {
+    const int resolution = CHUNK_SIZE >> lod;
+    SampleColumnFeatures(column, lod, data.features, false);
+
+    for (int z = 0; z < resolution; z++)
+    {
+      for (int x = 0; x < resolution; x++)
+      {
+        int i = TerrainColumn::Index(x, z);
+        data.biome[i] = chooseBiomeId(data.features[i]);
+        data.height[i] = computeTerrainHeight(data.features[i], world.minTerrainHeight, world.maxTerrainHeight);
+      }
+    }
+
+    const Biome &first = biomes[data.biome[0]];
+    data.maxHeight = data.height[0];
+    data.stoneTop = data.height[0] - first.topDepth - first.fillerDepth;
+    data.airBlock = first.airBlock;
+    data.stoneBlock = first.stoneBlock;
+    for (int z = 0; z < resolution; z++)
+    {
+      for (int x = 0; x < resolution; x++)
+      {
+        int i = TerrainColumn::Index(x, z);
+        const Biome &biome = biomes[data.biome[i]];
+        data.maxHeight = std::max(data.maxHeight, data.height[i]);
+        data.stoneTop = std::min(data.stoneTop, data.height[i] - biome.topDepth - biome.fillerDepth);
+        if (biome.airBlock != data.airBlock)
+          data.airBlock = -1;
+        if (biome.stoneBlock != data.stoneBlock)
+          data.stoneBlock = -1;
+      }
+    }
+
+    if (validateSampling)
+      ValidateColumnSampling(column, lod, data);
+  }
+
+  void ValidateColumnSampling(const glm::ivec2 &column, int lod, const TerrainColumn &data)
+  {
+    const int resolution = CHUNK_SIZE >> lod;
+    WorldFeatures exact[CHUNK_SIZE * CHUNK_SIZE];
+    SampleColumnFeatures(column, lod, exact, true);
+
+    float heightDeviation = 0.0f;
+    float featureDeviation = 0.0f;
+    for (int z = 0; z < resolution; z++)
+    {
+      for (int x = 0; x < resolution; x++)
+      {
+        int i = TerrainColumn::Index(x, z);
+        const WorldFeatures &a = exact[i];
+        const WorldFeatures &b = data.features[i];
+        for (float d : {a.continentalness - b.continentalness, a.elevation - b.elevation, a.erosion - b.erosion,
+                        a.humidity - b.humidity, a.temperature - b.temperature, a.weirdness - b.weirdness})
+          featureDeviation = std::max(featureDeviation, std::abs(d));
+
+        float exactHeight = computeTerrainHeight(a, world.minTerrainHeight, world.maxTerrainHeight);
+        float sampledHeight = computeTerrainHeight(b, world.minTerrainHeight, world.maxTerrainHeight);
+        heightDeviation = std::max(heightDeviation, std::abs(exactHeight - sampledHeight));
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(validationMutex);
+    validation.columns++;
+    validation.maxFeatureDeviation = std::max(validation.maxFeatureDeviation, featureDeviation);
+    if (heightDeviation > validation.maxHeightDeviation)
+    {
+      validation.maxHeightDeviation = heightDeviation;
+      std::cerr << "Coarse sampling max height deviation is now " << heightDeviation << " blocks (column " << column.x << ", " << column.y << ")" << std::endl;
+    }
+  }
+
+  SamplingValidation GetSamplingValidation()
+  {
+    std::lock_guard<std::mutex> lock(validationMutex);
+    return validation;
+  }
+
+  void ChunkSpawned(const glm::ivec3 &coord, int lod) override
+  {
+    columnCaches[lod].Retain({coord.x, coord.z});
+  }
+
+  void ChunkUnloaded(const glm::ivec3 &coord, int lod) override
+  {
+    columnCaches[lod].Release({coord.x, coord.z});
+  }
+
+  void ChunkLODChanged(const glm::ivec3 &coord, int oldLod, int newLod) override
+  {
+    columnCaches[newLod].Retain({coord.x, coord.z});
+    columnCaches[oldLod].Release({coord.x, coord.z});
+  }
+
   void GenerateVoxelData(Entity chunk) override
   {
     auto &chunkComp = StartGeneratingVoxelData(chunk);
 
-    int worldBaseX = chunkComp.worldPosition.x * CHUNK_SIZE;
-    int worldBaseZ = chunkComp.worldPosition.z * CHUNK_SIZE;
     int worldBaseY = chunkComp.worldPosition.y * CHUNK_SIZE;
+    const int lod = chunkComp.chunkLOD;
+    const int step = chunkComp.Step();
+    const int resolution = chunkComp.Resolution();
+
+    auto column = columnCaches[lod].Get({chunkComp.worldPosition.x, chunkComp.worldPosition.z}, [this, lod](const glm::ivec2 &coord, TerrainColumn &data)
+                                        { BuildTerrainColumn(coord, lod, data); });
+
+    // storage runs top down in y, so sample sy of a column is at topY - sy * step
+    const int topY = worldBaseY + CHUNK_SIZE - 1;
+    const int bottomY = topY - (resolution - 1) * step;
+    auto &voxels = chunkComp.voxelData;
+
+    // chunks entirely above the surface and water, or entirely inside the stone layer
+    if (bottomY > std::max(column->maxHeight, world.waterLevel) && column->airBlock >= 0)
+    {
+      std::fill(voxels.begin(), voxels.end(), Voxel{static_cast<uint32_t>(column->airBlock)});
+      return;
+    }
+    if (topY < column->stoneTop && bottomY > 0 && column->stoneBlock >= 0)
+    {
+      std::fill(voxels.begin(), voxels.end(), Voxel{static_cast<uint32_t>(column->stoneBlock)});
+      return;
+    }
 
-    for (int x = 0; x < CHUNK_SIZE; x++)
+    const size_t layerStride = (size_t)resolution * resolution;
+    for (int sz = 0; sz < resolution; sz++)
     {
-      int worldX = x + worldBaseX;
-      for (int z = 0; z < CHUNK_SIZE; z++)
+      for (int sx = 0; sx < resolution; sx++)
       {
-        int worldZ = z + worldBaseZ;
-        WorldFeatures features = generateWorldFeatures(worldX, worldZ);
-
-        const Biome &biome = chooseBiome(features);
-
-        int terrainHeight = computeTerrainHeight(features, world.minTerrainHeight, world.maxTerrainHeight);
-        for (int y = 0; y < CHUNK_SIZE; y++)
-        {
-          int worldY = worldBaseY + y;
-
-          if (worldY > terrainHeight && worldY > world.waterLevel)
-          {
-            createVoxel(chunkComp, x, y, z, biome.airBlock);
-            continue;
-          }
-          else if (worldY > terrainHeight && worldY < world.waterLevel)
-          {
-            createVoxel(chunkComp, x, y, z, biome.waterBlock);
-            continue;
-          }
-
-          int depth = terrainHeight - worldY;
-
-          if (depth < biome.topDepth)
-          {
-            createVoxel(chunkComp, x, y, z, biome.topBlock);
-          }
-          else if (depth <= biome.topDepth + biome.fillerDepth)
-          {
-            createVoxel(chunkComp, x, y, z, biome.fillerBlock);
-          }
-          else if (depth < terrainHeight)
-          {
-            createVoxel(chunkComp, x, y, z, biome.stoneBlock);
-          }
-          else
-          {
-            createVoxel(chunkComp, x, y, z, biome.bottomBlock);
-          }
-        }
+        int i = TerrainColumn::Index(sx, sz);
+        Voxel *out = voxels.data() + sx + resolution * sz;
+        FillTerrainColumn(out, layerStride, resolution, topY, step, column->height[i], world.waterLevel, biomes[column->biome[i]]);
       }
     }
   }
+
+private:
+  std::mutex biomeIndexMutex;
+  std::atomic<bool> biomeIndexReady = false;
+
+  std::mutex validationMutex;
+  SamplingValidation validation;
 };
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+#include "defaultGen.hpp"
+
+// The world the game generates: terrain settings, block types and biomes. Shared with the headless
+// tools so a pregenerated save holds the same chunks the game would generate for a seed.
+void ConfigureDefaultTerrain(WorldComponent &world);
+void AddDefaultBlocksAndBiomes(WorldComponent &world, DefaultVoxelSystem &voxelSystem);
@@ -1,4 +1,5 @@
 #include <cstring>
+#include <algorithm>
 #include "renderSystem.hpp"
 #include "renderer.hpp"
 #include "mesh.hpp"
@@ -8,18 +9,27 @@
 
 #include "profiler.hpp"
 
-void RenderSystem::Init(std::shared_ptr<Coordinator> coordinator, int screenWidth, int screenHeight)
+void RenderSystem::Init(std::shared_ptr<Coordinator> coordinator, std::shared_ptr<TransformSystem> transformSystem, int screenWidth, int screenHeight)
 {
   gCoordinator = coordinator;
+  this->transformSystem = transformSystem;
   this->screenWidth = screenWidth;
   this->screenHeight = screenHeight;
 }
 
 void RenderSystem::Update(Renderer &renderer, float deltaTime, const Camera &camera)
 {
-  renderer.startFrame();
+  {
+    PROFILE_ZONE("Renderer::startFrame");
+    renderer.startFrame();
+  }
   RenderScene(renderer, deltaTime, camera);
-  renderer.endFrame();
+  if (drawOverlay)
+    drawOverlay(renderer.commandBuffers[renderer.currentFrame]);
+  {
+    PROFILE_ZONE("Renderer::endFrame");
+    renderer.endFrame();
+  }
 }
 
 bool FrustumIntersects(const Frustum &frustum, const glm::vec3 &center, const glm::vec3 &halfSize)
@@ -43,6 +53,7 @@ bool FrustumIntersects(const Frustum &frustum, const glm::vec3 &center, const gl
 
 void RenderSystem::RenderScene(Renderer &renderer, float deltaTime, const Camera &camera)
 {
+  PROFILE_ZONE("RenderSystem::RenderScene");
 
   glm::mat4 view = camera.getViewMatrix();
   glm::mat4 proj = camera.getProjectionMatrix(renderer.swapChainObjects.swapChainExtent.width / (float)renderer.swapChainObjects.swapChainExtent.height);
@@ -73,23 +84,7 @@ void RenderSystem::RenderScene(Renderer &renderer, float deltaTime, const Camera
     setScissor(cmdBuff, scissor);
   }
 
-  for (auto const &entity : mEntities)
-  {
-    if (gCoordinator->HasComponent<MeshComponent>(entity))
-    {
-      auto &mesh = gCoordinator->GetComponent<MeshComponent>(entity);
-
-      std::vector<VkDescriptorSet> sets = {cameraSet, mesh.mesh->texture.imageSet};
-      bindDescriptorSets(sets, cmdBuff, renderer.pipelineLayout);
-
-      PushConstants pc{};
-      pc.model = getWorldMatrix(entity);
-
-      vkCmdPushConstants(cmdBuff, renderer.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &pc);
-
-      mesh.mesh->Draw();
-    }
-  }
+  DrawMeshInstances(renderer, cameraSet);
 
   {
     bindGraphicsPipeline(cmdBuff, renderer.voxelPipeline);
@@ -131,24 +126,69 @@ void RenderSystem::RenderScene(Renderer &renderer, float deltaTime, const Camera
   bindVertexBuffer(renderer.voxelBuffers.vertexBuffer, cmdBuff);
   bindIndexBuffer(renderer.voxelBuffers.indexBuffer, cmdBuff);
   vkCmdDrawIndexedIndirect(cmdBuff, renderer.voxelBuffers.indirectBuffer, 0, renderer.voxelBuffers.drawCount, sizeof(VkDrawIndexedIndirectCommand));
+  stats.voxelDraws = renderer.voxelBuffers.drawCount;
 }
 
-glm::mat4 RenderSystem::getWorldMatrix(Entity entity)
+void RenderSystem::DrawMeshInstances(Renderer &renderer, VkDescriptorSet cameraSet)
 {
-  glm::mat4 result(1.0f);
-
-  Entity current = entity;
+  uint32_t currentFrame = renderer.currentFrame;
+  VkCommandBuffer cmdBuff = renderer.commandBuffers[currentFrame];
 
-  while (current != -1 && gCoordinator->HasComponent<TransformComponent>(current))
+  // group by texture then mesh so every group is one instanced draw and textures are bound once
+  stats.meshDraws = 0;
+  meshInstances.clear();
+  for (auto const &entity : mEntities)
   {
-    auto &t = gCoordinator->GetComponent<TransformComponent>(current);
-    result = t.GetMatrix() * result;
+    if (gCoordinator->HasComponent<MeshComponent>(entity))
+    {
+      auto &mesh = gCoordinator->GetComponent<MeshComponent>(entity);
+      meshInstances.push_back({mesh.mesh.get(), mesh.mesh->texture.imageSet, entity});
+    }
+  }
 
-    if (!gCoordinator->HasComponent<Parent>(current))
-      break;
+  std::sort(meshInstances.begin(), meshInstances.end(), [](const MeshInstance &a, const MeshInstance &b)
+            {
+              if (a.imageSet != b.imageSet)
+                return std::less<VkDescriptorSet>()(a.imageSet, b.imageSet);
+              return std::less<Mesh *>()(a.mesh, b.mesh); });
 
-    current = gCoordinator->GetComponent<Parent>(current).value;
+  if (meshInstances.size() > MAX_MESH_INSTANCES)
+  {
+    static bool warned = false;
+    if (!warned)
+    {
+      std::cerr << "Too many mesh instances, only the first " << MAX_MESH_INSTANCES << " are drawn." << std::endl;
+      warned = true;
+    }
+    meshInstances.resize(MAX_MESH_INSTANCES);
   }
 
-  return result;
-}
\ No newline at end of file
+  // the fence for this frame has been waited on, so its instance buffer is free to overwrite
+  ShaderBufferObject *instanceData = static_cast<ShaderBufferObject *>(renderer.instanceBuffersMapped[currentFrame]);
+  VkDescriptorSet boundImageSet = VK_NULL_HANDLE;
+
+  size_t begin = 0;
+  while (begin < meshInstances.size())
+  {
+    const MeshInstance &first = meshInstances[begin];
+
+    size_t end = begin;
+    while (end < meshInstances.size() && meshInstances[end].mesh == first.mesh && meshInstances[end].imageSet == first.imageSet)
+    {
+      instanceData[end].model = transformSystem->GetWorldMatrix(meshInstances[end].entity);
+      end++;
+    }
+
+    if (first.imageSet != boundImageSet)
+    {
+      std::vector<VkDescriptorSet> sets = {cameraSet, first.imageSet, renderer.instanceSets[currentFrame]};
+      bindDescriptorSets(sets, cmdBuff, renderer.pipelineLayout);
+      boundImageSet = first.imageSet;
+    }
+
+    first.mesh->DrawInstanced(static_cast<uint32_t>(end - begin), static_cast<uint32_t>(begin));
+    stats.meshDraws++;
+    begin = end;
+  }
+  stats.meshInstances = static_cast<uint32_t>(meshInstances.size());
+}
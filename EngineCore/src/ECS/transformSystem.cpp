@@ -0,0 +1,310 @@
+#include "transformSystem.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Same result as TransformComponent::GetMatrix (translate * rotX * rotY * rotZ * scale),
+// but written out directly instead of going through three generic axis rotations.
+static glm::mat4 ComposeTransform(const glm::vec3 &translation, const glm::vec3 &rotation, const glm::vec3 &scale)
+{
+  const float ax = glm::radians(rotation.x);
+  const float ay = glm::radians(rotation.y);
+  const float az = glm::radians(rotation.z);
+
+  const float sa = std::sin(ax), ca = std::cos(ax);
+  const float sb = std::sin(ay), cb = std::cos(ay);
+  const float sc = std::sin(az), cc = std::cos(az);
+
+  glm::mat4 mat;
+  mat[0] = glm::vec4(cb * cc, ca * sc + sa * sb * cc, sa * sc - ca * sb * cc, 0.0f) * scale.x;
+  mat[1] = glm::vec4(-cb * sc, ca * cc - sa * sb * sc, sa * cc + ca * sb * sc, 0.0f) * scale.y;
+  mat[2] = glm::vec4(sb, -sa * cb, ca * cb, 0.0f) * scale.z;
+  mat[3] = glm::vec4(translation, 1.0f);
+  return mat;
+}
+
+void TransformSystem::Init(std::shared_ptr<Coordinator> coordinator)
+{
+  gCoordinator = coordinator;
+}
+
+void TransformSystem::MarkDirty(Entity entity)
+{
+  auto it = mSlots.find(entity);
+  if (it != mSlots.end())
+    mDirty[it->second] = 1;
+}
+
+void TransformSystem::MarkHierarchyDirty()
+{
+  mHierarchyDirty = true;
+}
+
+const glm::mat4 &TransformSystem::GetWorldMatrix(Entity entity) const
+{
+  static const glm::mat4 identity(1.0f);
+
+  auto it = mSlots.find(entity);
+  if (it == mSlots.end())
+    return identity;
+
+  return mWorld[it->second];
+}
+
+void TransformSystem::Update()
+{
+  if (mHierarchyDirty || (mBuiltVersion != mVersion && !UpdateMembership()))
+    RebuildOrder();
+
+  const size_t count = mOrder.size();
+
+  // pick up edited transforms
+  for (size_t i = 0; i < count; i++)
+  {
+    auto const &transform = gCoordinator->GetComponent<TransformComponent>(mOrder[i]);
+
+    if (!mDirty[i] && transform.translation == mTranslation[i] && transform.rotation == mRotation[i] && transform.scale == mScale[i])
+      continue;
+
+    mTranslation[i] = transform.translation;
+    mRotation[i] = transform.rotation;
+    mScale[i] = transform.scale;
+    mLocal[i] = ComposeTransform(transform.translation, transform.rotation, transform.scale);
+    mDirty[i] = 1;
+  }
+
+  // parents come first, so a single pass carries dirtiness down to every child
+  for (size_t i = 0; i < count; i++)
+  {
+    const uint32_t parent = mParentSlot[i];
+    if (parent != NO_PARENT)
+      mDirty[i] |= mDirty[parent];
+
+    if (!mDirty[i])
+      continue;
+
+    mWorld[i] = parent == NO_PARENT ? mLocal[i] : mWorld[parent] * mLocal[i];
+  }
+
+  std::fill(mDirty.begin(), mDirty.end(), 0);
+}
+
+// Chunk meshes come and go every frame while the world streams, and they are roots or leaves, so
+// entities leaving without children and entities joining under an already ordered parent keep the
+// order and every cached matrix. Everything else falls back to RebuildOrder.
+bool TransformSystem::UpdateMembership()
+{
+  const uint32_t count = static_cast<uint32_t>(mOrder.size());
+
+  std::vector<Entity> added;
+  size_t kept = 0;
+  for (Entity entity : mEntities)
+  {
+    if (mSlots.count(entity))
+      kept++;
+    else if (mMissingParents.count(entity))
+      return false; // transformed entities would gain this one as their parent
+    else
+      added.push_back(entity);
+  }
+
+  // every join and leave bumps the version once, a mismatch means an id left and came back
+  const size_t removedCount = count - kept;
+  if (mVersion - mBuiltVersion != removedCount + added.size())
+    return false;
+
+  if (removedCount > 0)
+  {
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+      if (mChildCount[slot] > 0 && !mEntities.count(mOrder[slot]))
+        return false;
+    }
+
+    // compacting keeps the relative order, so parents still come before their children
+    std::vector<uint32_t> newSlot(count, NO_PARENT);
+    uint32_t write = 0;
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+      const uint32_t parent = mParentSlot[slot];
+      if (!mEntities.count(mOrder[slot]))
+      {
+        mSlots.erase(mOrder[slot]);
+        if (parent != NO_PARENT)
+          mChildCount[parent]--;
+        continue;
+      }
+
+      newSlot[slot] = write;
+      mOrder[write] = mOrder[slot];
+      mParentSlot[write] = parent == NO_PARENT ? NO_PARENT : newSlot[parent];
+      mLocal[write] = mLocal[slot];
+      mWorld[write] = mWorld[slot];
+      mDirty[write] = mDirty[slot];
+      mChildCount[write] = mChildCount[slot];
+      mTranslation[write] = mTranslation[slot];
+      mRotation[write] = mRotation[slot];
+      mScale[write] = mScale[slot];
+      mSlots[mOrder[write]] = write;
+      write++;
+    }
+
+    mOrder.resize(write);
+    mParentSlot.resize(write);
+    mLocal.resize(write);
+    mWorld.resize(write);
+    mDirty.resize(write);
+    mChildCount.resize(write);
+    mTranslation.resize(write);
+    mRotation.resize(write);
+    mScale.resize(write);
+  }
+
+  // appended after everything that is already ordered, so after their parent too
+  for (Entity entity : added)
+  {
+    uint32_t parent = NO_PARENT;
+    if (gCoordinator->HasComponent<Parent>(entity))
+    {
+      Entity parentEntity = gCoordinator->GetComponent<Parent>(entity).value;
+      auto it = mSlots.find(parentEntity);
+      if (it != mSlots.end())
+      {
+        parent = it->second;
+        mChildCount[parent]++;
+      }
+      else if (mEntities.count(parentEntity))
+        return false; // the parent joins later in this batch, RebuildOrder starts over from scratch
+      else if (parentEntity != entity)
+        mMissingParents.insert(parentEntity);
+    }
+
+    const uint32_t slot = static_cast<uint32_t>(mOrder.size());
+    mOrder.push_back(entity);
+    mParentSlot.push_back(parent);
+    mLocal.emplace_back(1.0f);
+    mWorld.emplace_back(1.0f);
+    mDirty.push_back(1);
+    mChildCount.push_back(0);
+    mTranslation.emplace_back(0.0f);
+    mRotation.emplace_back(0.0f);
+    mScale.emplace_back(0.0f);
+    mSlots[entity] = slot;
+  }
+
+  mBuiltVersion = mVersion;
+  return true;
+}
+
+void TransformSystem::RebuildOrder()
+{
+  std::vector<Entity> entities(mEntities.begin(), mEntities.end());
+  const uint32_t count = static_cast<uint32_t>(entities.size());
+
+  std::unordered_map<Entity, uint32_t> index;
+  index.reserve(count);
+  for (uint32_t i = 0; i < count; i++)
+    index[entities[i]] = i;
+
+  // parent of every entity, only parents that are transformed themselves count
+  std::vector<uint32_t> parents(count, NO_PARENT);
+  std::vector<uint32_t> childCounts(count + 1, 0);
+  mMissingParents.clear();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (!gCoordinator->HasComponent<Parent>(entities[i]))
+      continue;
+
+    Entity parentEntity = gCoordinator->GetComponent<Parent>(entities[i]).value;
+    auto it = index.find(parentEntity);
+    if (it == index.end())
+      mMissingParents.insert(parentEntity);
+    if (it == index.end() || it->second == i)
+      continue;
+
+    parents[i] = it->second;
+    childCounts[it->second + 1]++;
+  }
+
+  // children of every entity packed into one array
+  for (uint32_t i = 0; i < count; i++)
+    childCounts[i + 1] += childCounts[i];
+
+  std::vector<uint32_t> children(childCounts[count]);
+  std::vector<uint32_t> fill(childCounts.begin(), childCounts.end() - 1);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (parents[i] != NO_PARENT)
+      children[fill[parents[i]]++] = i;
+  }
+
+  // depth first from every root, which keeps each subtree contiguous
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> slotOf(count, NO_PARENT);
+  std::vector<uint32_t> stack;
+  order.reserve(count);
+
+  auto visit = [&](uint32_t root)
+  {
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+      uint32_t node = stack.back();
+      stack.pop_back();
+
+      if (slotOf[node] != NO_PARENT)
+        continue;
+
+      slotOf[node] = static_cast<uint32_t>(order.size());
+      order.push_back(node);
+
+      for (uint32_t c = childCounts[node + 1]; c > childCounts[node]; c--)
+        stack.push_back(children[c - 1]);
+    }
+  };
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (parents[i] == NO_PARENT)
+      visit(i);
+  }
+
+  // anything left over is part of a parent cycle, break it so the entities still get a transform
+  if (order.size() != count)
+  {
+    std::cerr << "Transform hierarchy contains a cycle, treating the affected entities as roots." << std::endl;
+    for (uint32_t i = 0; i < count; i++)
+    {
+      if (slotOf[i] != NO_PARENT)
+        continue;
+
+      parents[i] = NO_PARENT;
+      visit(i);
+    }
+  }
+
+  mOrder.resize(count);
+  mParentSlot.resize(count);
+  mLocal.resize(count);
+  mWorld.resize(count);
+  mTranslation.resize(count);
+  mRotation.resize(count);
+  mScale.resize(count);
+  mDirty.assign(count, 1);
+  mChildCount.assign(count, 0);
+
+  mSlots.clear();
+  mSlots.reserve(count);
+  for (uint32_t slot = 0; slot < count; slot++)
+  {
+    uint32_t i = order[slot];
+    mOrder[slot] = entities[i];
+    mParentSlot[slot] = parents[i] == NO_PARENT ? NO_PARENT : slotOf[parents[i]];
+    mSlots[entities[i]] = slot;
+    if (mParentSlot[slot] != NO_PARENT)
+      mChildCount[mParentSlot[slot]]++;
+  }
+
+  mBuiltVersion = mVersion;
+  mHierarchyDirty = false;
+}
@@ -112,14 +112,15 @@ void submitFrame(VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage, VkSe
   VkSubmitInfo submitInfo{};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  submitInfo.waitSemaphoreCount = 1;
+  // headless frames have no image to acquire or present, so nothing to wait on or signal
+  submitInfo.waitSemaphoreCount = waitSemaphore != VK_NULL_HANDLE ? 1 : 0;
   submitInfo.pWaitSemaphores = &waitSemaphore;
   submitInfo.pWaitDstStageMask = &waitStage;
 
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.signalSemaphoreCount = signalSemaphore != VK_NULL_HANDLE ? 1 : 0;
   submitInfo.pSignalSemaphores = &signalSemaphore;
 
   VkResult res = vkQueueSubmit(graphicsQueue, 1, &submitInfo, fence);
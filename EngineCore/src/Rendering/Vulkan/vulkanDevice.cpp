@@ -82,8 +82,15 @@ VkDevice createLogicalDevice(VkSurfaceKHR surface, VkPhysicalDevice physicalDevi
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  if (surface != VK_NULL_HANDLE) // headless devices never present, so they need no swapchain
+  {
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  }
+  else
+  {
+    createInfo.enabledExtensionCount = 0;
+  }
 
   if (enableValidationLayers)
   {
@@ -130,10 +137,12 @@ int rateDeviceSuitability(VkSurfaceKHR surface, VkPhysicalDevice physicalDevice)
 
   score += deviceProperties.limits.maxImageDimension2D;
 
-  bool extensionsSupported = checkDeviceExtensionSupport(physicalDevice);
+  // without a surface the device renders offscreen, software drivers like lavapipe qualify too
+  bool headless = surface == VK_NULL_HANDLE;
+  bool extensionsSupported = headless || checkDeviceExtensionSupport(physicalDevice);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported)
+  bool swapChainAdequate = headless;
+  if (!headless && extensionsSupported)
   {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(surface, physicalDevice);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -188,7 +197,14 @@ QueueFamilyIndices findQueueFamilies(VkSurfaceKHR surface, VkPhysicalDevice phys
     }
 
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+    if (surface != VK_NULL_HANDLE)
+    {
+      vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+    }
+    else
+    {
+      presentSupport = indices.graphicsFamily.has_value(); // nothing is presented headless, use the graphics queue
+    }
     if (presentSupport)
     {
       indices.presentFamily = i;
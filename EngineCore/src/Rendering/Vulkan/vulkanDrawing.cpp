@@ -39,5 +39,5 @@ void draw(VkCommandBuffer commandBuffer, int vertexCount, int instanceCount, int
 
 void drawIndexed(VkCommandBuffer commandBuffer, int indicesCount, int instanceCount, int firstVertex, int firstInstance)
 {
-  vkCmdDrawIndexed(commandBuffer, indicesCount, 1, 0, 0, 0);
+  vkCmdDrawIndexed(commandBuffer, indicesCount, instanceCount, 0, firstVertex, firstInstance);
 }
\ No newline at end of file
@@ -14,6 +14,9 @@ void framebufferResizeCallback(GLFWwindow *window, int width, int height)
 void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 {
   auto app = reinterpret_cast<Application *>(glfwGetWindowUserPointer(window));
+  if (app->performanceOverlay.visible) // the cursor is free for the overlay
+    return;
+
   if (app->firstMouse)
   {
     app->lastX = (float)xpos;
@@ -101,16 +104,20 @@ VkInstance createInstance(GLFWwindow *window)
     createInfo.enabledLayerCount = 0;
   }
 
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
   std::vector<const char *> requiredExtensions;
 
-  for (uint32_t i = 0; i < glfwExtensionCount; i++)
+  // headless instances render offscreen and need no surface extensions, GLFW is not even initialized
+  if (window)
   {
-    requiredExtensions.emplace_back(glfwExtensions[i]);
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+    for (uint32_t i = 0; i < glfwExtensionCount; i++)
+    {
+      requiredExtensions.emplace_back(glfwExtensions[i]);
+    }
   }
 
 #ifdef __APPLE__
@@ -125,7 +132,10 @@ VkInstance createInstance(GLFWwindow *window)
   if (res != VK_SUCCESS)
   {
     std::cerr << "Failed to create Vulkan instance. Error: " << res << std::endl;
-    glfwDestroyWindow(window);
+    if (window)
+    {
+      glfwDestroyWindow(window);
+    }
     glfwTerminate();
     std::cerr << "Press Enter to exit..." << std::endl;
     std::cin.get();
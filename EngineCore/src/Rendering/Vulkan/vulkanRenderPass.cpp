@@ -12,8 +12,11 @@ VkRenderPass createRenderPass(const SwapChainObjects &swapChainObjects, VkDevice
   colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
+  // offscreen targets have no swapchain to present to, their images are copied out instead
+  bool offscreen = swapChainObjects.swapChain == VK_NULL_HANDLE;
+
   colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // can be an image as final layout btw
+  colorAttachment.finalLayout = offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // can be an image as final layout btw
 
   VkAttachmentReference colorAttachmentRef{};
   colorAttachmentRef.attachment = 0;
@@ -47,6 +50,17 @@ VkRenderPass createRenderPass(const SwapChainObjects &swapChainObjects, VkDevice
   dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
   dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+  // copies recorded after the render pass wait for the color writes
+  VkSubpassDependency copyDependency{};
+  copyDependency.srcSubpass = 0;
+  copyDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+  copyDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  copyDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  copyDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  copyDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+  std::array<VkSubpassDependency, 2> dependencies = {dependency, copyDependency};
+
   std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
   VkRenderPassCreateInfo renderPassInfo{};
   renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -54,8 +68,8 @@ VkRenderPass createRenderPass(const SwapChainObjects &swapChainObjects, VkDevice
   renderPassInfo.pAttachments = attachments.data();
   renderPassInfo.subpassCount = 1;
   renderPassInfo.pSubpasses = &subpass;
-  renderPassInfo.dependencyCount = 1;
-  renderPassInfo.pDependencies = &dependency;
+  renderPassInfo.dependencyCount = offscreen ? 2 : 1;
+  renderPassInfo.pDependencies = dependencies.data();
 
   VkRenderPass renderPass;
   if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
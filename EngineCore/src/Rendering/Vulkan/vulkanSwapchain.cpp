@@ -104,9 +104,31 @@ void cleanupSwapChain(SwapChainObjects &swapChainObjects, VkDevice device)
 
   destroySwapchainFramebuffers(swapChainObjects, device);
   destroyImageViews(swapChainObjects.swapChainImageViews, device);
+  for (size_t i = 0; i < swapChainObjects.offscreenImageMemory.size(); i++)
+  {
+    destroyTextureImage(swapChainObjects.swapChainImages[i], swapChainObjects.offscreenImageMemory[i], device);
+  }
+  swapChainObjects.offscreenImageMemory.clear();
   destroySwapChain(swapChainObjects.swapChain, device);
 }
 
+SwapChainObjects createOffscreenTarget(VkExtent2D extent, uint32_t imageCount, VkDevice device, VkPhysicalDevice physicalDevice)
+{
+  SwapChainObjects swapChainObjects;
+  swapChainObjects.swapChain = VK_NULL_HANDLE;
+  swapChainObjects.swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB; // same encoding as the B8G8R8A8_SRGB swapchain
+  swapChainObjects.swapChainExtent = extent;
+
+  swapChainObjects.swapChainImages.resize(imageCount);
+  swapChainObjects.offscreenImageMemory.resize(imageCount);
+  for (uint32_t i = 0; i < imageCount; i++)
+  {
+    createImage(extent.width, extent.height, swapChainObjects.swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainObjects.swapChainImages[i], swapChainObjects.offscreenImageMemory[i], device, physicalDevice);
+  }
+
+  return swapChainObjects;
+}
+
 void destroySwapChain(VkSwapchainKHR swapChain, VkDevice device)
 {
   if (swapChain != VK_NULL_HANDLE)
@@ -59,3 +59,19 @@ void FreeListAllocator::free(uint32_t offset, uint32_t size)
     }
   }
 }
+
+uint32_t FreeListAllocator::freeSize() const
+{
+  uint32_t total = 0;
+  for (const FreeRange &r : freeRanges)
+    total += r.size;
+  return total;
+}
+
+uint32_t FreeListAllocator::largestFreeRange() const
+{
+  uint32_t largest = 0;
+  for (const FreeRange &r : freeRanges)
+    largest = std::max(largest, r.size);
+  return largest;
+}
@@ -0,0 +1,171 @@
+#include "cameraPath.hpp"
+#include "stutterDetector.hpp"
+#include "json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+static const char *PathHeader = "camera_path";
+static const int PathVersion = 1;
+
+bool CameraPath::Save(const std::string &path) const
+{
+  std::ofstream file(path);
+  if (!file.is_open())
+  {
+    std::cerr << "Failed to open camera path! File: " << path << std::endl;
+    return false;
+  }
+
+  file.precision(std::numeric_limits<float>::max_digits10);
+  file << PathHeader << ' ' << PathVersion << ' ' << timestep << '\n';
+  for (const CameraPathFrame &frame : frames)
+    file << frame.position.x << ' ' << frame.position.y << ' ' << frame.position.z << ' ' << frame.yaw << ' ' << frame.pitch << '\n';
+  return file.good();
+}
+
+bool CameraPath::Load(const std::string &path)
+{
+  std::ifstream file(path);
+  if (!file.is_open())
+  {
+    std::cerr << "Failed to open camera path! File: " << path << std::endl;
+    return false;
+  }
+
+  std::string header;
+  int version = 0;
+  float fileTimestep = 0.0f;
+  if (!(file >> header >> version >> fileTimestep) || header != PathHeader || version != PathVersion || !(fileTimestep > 0.0f))
+  {
+    std::cerr << "Invalid camera path! File: " << path << std::endl;
+    return false;
+  }
+
+  std::vector<CameraPathFrame> loaded;
+  CameraPathFrame frame;
+  while (file >> frame.position.x >> frame.position.y >> frame.position.z >> frame.yaw >> frame.pitch)
+    loaded.push_back(frame);
+  if (!file.eof())
+  {
+    std::cerr << "Invalid camera path frame " << loaded.size() << "! File: " << path << std::endl;
+    return false;
+  }
+
+  timestep = fileTimestep;
+  frames = std::move(loaded);
+  return true;
+}
+
+CameraPath CameraPath::Line(const glm::vec3 &from, const glm::vec3 &to, float speed, float timestep)
+{
+  CameraPath path;
+  path.timestep = timestep;
+
+  const glm::vec3 offset = to - from;
+  const float length = glm::length(offset);
+  const glm::vec3 direction = length > 0.0f ? offset / length : glm::vec3(1.0f, 0.0f, 0.0f);
+  const float yaw = glm::degrees(std::atan2(direction.z, direction.x));
+  const float pitch = glm::degrees(std::asin(glm::clamp(direction.y, -1.0f, 1.0f)));
+
+  const size_t steps = std::max<size_t>(1, (size_t)std::ceil(length / (speed * timestep)));
+  path.frames.reserve(steps + 1);
+  for (size_t i = 0; i <= steps; i++)
+    path.frames.push_back({from + offset * ((float)i / steps), yaw, pitch});
+  return path;
+}
+
+CameraPathRecorder::CameraPathRecorder(float timestep)
+{
+  path.timestep = timestep;
+}
+
+void CameraPathRecorder::Record(const Camera &camera, float deltaTime)
+{
+  const CameraPathFrame current{camera.Position, camera.Yaw, camera.Pitch};
+  if (!started)
+  {
+    path.frames.push_back(current);
+    previous = current;
+    nextSampleTime = path.timestep;
+    started = true;
+    return;
+  }
+
+  // frames rarely land on the timestep, interpolate between the two frames around each sample
+  const double currentTime = previousTime + deltaTime;
+  while (nextSampleTime <= currentTime)
+  {
+    const float t = currentTime > previousTime ? (float)((nextSampleTime - previousTime) / (currentTime - previousTime)) : 1.0f;
+    path.frames.push_back({glm::mix(previous.position, current.position, t), previous.yaw + (current.yaw - previous.yaw) * t,
+                           previous.pitch + (current.pitch - previous.pitch) * t});
+    nextSampleTime += path.timestep;
+  }
+  previous = current;
+  previousTime = currentTime;
+}
+
+bool ReplayReport::Write(const std::string &path, const std::string &cameraPath) const
+{
+  FrameTimeHistogram histogram;
+  double totalMs = 0.0;
+  size_t created = 0, generated = 0, meshed = 0, uploaded = 0, bytesUploaded = 0;
+
+  nlohmann::json perFrame = nlohmann::json::array();
+  for (const Frame &frame : frames)
+  {
+    histogram.Add(frame.ms);
+    totalMs += frame.ms;
+    created += frame.chunksCreated;
+    generated += frame.chunksGenerated;
+    meshed += frame.chunksMeshed;
+    uploaded += frame.meshesUploaded;
+    bytesUploaded += frame.bytesUploaded;
+
+    perFrame.push_back({{"ms", frame.ms},
+                        {"input_ms", frame.stages.input},
+                        {"voxels_ms", frame.stages.voxels},
+                        {"meshing_ms", frame.stages.meshing},
+                        {"transforms_ms", frame.stages.transforms},
+                        {"render_ms", frame.stages.render},
+                        {"loaded_chunks", frame.loadedChunks},
+                        {"queued_chunks", frame.queuedChunks},
+                        {"chunks_created", frame.chunksCreated},
+                        {"chunks_generated", frame.chunksGenerated},
+                        {"chunks_meshed", frame.chunksMeshed},
+                        {"meshes_uploaded", frame.meshesUploaded},
+                        {"bytes_uploaded", frame.bytesUploaded}});
+  }
+
+  nlohmann::json summary = {{"frames", frames.size()},
+                            {"seconds", totalMs / 1000.0},
+                            {"mean_ms", frames.empty() ? 0.0 : totalMs / frames.size()},
+                            {"p50_ms", histogram.Percentile(0.50)},
+                            {"p95_ms", histogram.Percentile(0.95)},
+                            {"p99_ms", histogram.Percentile(0.99)},
+                            {"max_ms", histogram.Max()},
+                            {"chunks_created", created},
+                            {"chunks_generated", generated},
+                            {"chunks_meshed", meshed},
+                            {"meshes_uploaded", uploaded},
+                            {"bytes_uploaded", bytesUploaded}};
+
+  printf("Replay of %s: %zu frames in %.2f s, frame ms p50 %.2f  p95 %.2f  p99 %.2f  max %.2f, %zu chunks generated, %zu meshed\n",
+         cameraPath.c_str(), frames.size(), totalMs / 1000.0, histogram.Percentile(0.50), histogram.Percentile(0.95),
+         histogram.Percentile(0.99), histogram.Max(), generated, meshed);
+
+  std::ofstream file(path);
+  if (!file.is_open())
+  {
+    std::cerr << "Failed to open replay report! File: " << path << std::endl;
+    return false;
+  }
+
+  nlohmann::json report = {{"camera_path", cameraPath}, {"summary", summary}, {"per_frame", std::move(perFrame)}};
+  file << report.dump(2) << std::endl;
+  return true;
+}
@@ -3,6 +3,7 @@
 #include "uniformData.hpp"
 #include <cstring>
 #include "vulkanBufferUtils.hpp"
+#include "profiler.hpp"
 
 Mesh::Mesh(Renderer &renderer) : renderer(renderer)
 {
@@ -10,6 +11,7 @@ Mesh::Mesh(Renderer &renderer) : renderer(renderer)
 
 void Mesh::Init(Texture texture, const std::vector<Vertex> &verts, const std::vector<uint32_t> &inds)
 {
+  PROFILE_ZONE("Mesh::Init");
   this->texture = texture;
   vertices = verts;
   indices = inds;
@@ -42,6 +44,15 @@ void Mesh::Draw()
   drawIndexed(commandBuffer, indices.size());
 }
 
+void Mesh::DrawInstanced(uint32_t instanceCount, uint32_t firstInstance)
+{
+  uint32_t currentFrame = renderer.currentFrame;
+  VkCommandBuffer commandBuffer = renderer.commandBuffers[currentFrame];
+  bindVertexBuffer(vertexBuffer, commandBuffer);
+  bindIndexBuffer(indexBuffer, commandBuffer);
+  drawIndexed(commandBuffer, indices.size(), instanceCount, 0, firstInstance);
+}
+
 VkBuffer Mesh::GetVertexBuffer() const
 {
   return vertexBuffer;
@@ -0,0 +1,197 @@
+#include "performanceOverlay.hpp"
+#include "renderer.hpp"
+#include "renderSystem.hpp"
+#include "voxelSystem.hpp"
+#include "meshingSystem.hpp"
+
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_vulkan.h"
+
+#include <algorithm>
+#include <cstdio>
+
+static constexpr double MiB = 1024.0 * 1024.0;
+
+static void CheckVkResult(VkResult result)
+{
+  if (result != VK_SUCCESS)
+    std::cerr << "ImGui Vulkan call failed! Result: " << result << std::endl;
+}
+
+void PerformanceOverlay::Init(Renderer &renderer, GLFWwindow *window)
+{
+  IMGUI_CHECKVERSION();
+  ImGui::CreateContext();
+  ImGui::GetIO().IniFilename = nullptr; // the window always opens in the same place
+  ImGui::StyleColorsDark();
+
+  // chains to the callbacks the window already has, so camera input keeps working
+  ImGui_ImplGlfw_InitForVulkan(window, true);
+
+  const uint32_t imageCount = static_cast<uint32_t>(renderer.swapChainObjects.swapChainImages.size());
+  ImGui_ImplVulkan_InitInfo initInfo{};
+  initInfo.Instance = renderer.instance;
+  initInfo.PhysicalDevice = renderer.physicalDevice;
+  initInfo.Device = renderer.device;
+  initInfo.QueueFamily = findQueueFamilies(renderer.surface, renderer.physicalDevice).graphicsFamily.value();
+  initInfo.Queue = renderer.graphicsQueue;
+  initInfo.DescriptorPool = renderer.descriptorPool;
+  initInfo.RenderPass = renderer.renderPass;
+  initInfo.MinImageCount = std::max(imageCount, 2u);
+  initInfo.ImageCount = std::max(imageCount, 2u);
+  initInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+  initInfo.CheckVkResultFn = CheckVkResult;
+  ImGui_ImplVulkan_Init(&initInfo);
+
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  vkGetPhysicalDeviceMemoryProperties(renderer.physicalDevice, &memoryProperties);
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+  {
+    if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+      deviceLocalHeap = std::max(deviceLocalHeap, memoryProperties.memoryHeaps[i].size);
+  }
+
+  initialized = true;
+}
+
+void PerformanceOverlay::Cleanup()
+{
+  if (!initialized)
+    return;
+
+  ImGui_ImplVulkan_Shutdown();
+  ImGui_ImplGlfw_Shutdown();
+  ImGui::DestroyContext();
+  initialized = false;
+}
+
+void PerformanceOverlay::AddFrameTime(float ms)
+{
+  frameTimes[nextFrameTime] = ms;
+  nextFrameTime = (nextFrameTime + 1) % HistoryLength;
+}
+
+bool PerformanceOverlay::WantsKeyboard() const
+{
+  return initialized && visible && ImGui::GetIO().WantCaptureKeyboard;
+}
+
+// Fragmentation is the share of free space outside the largest free range, an allocation bigger than
+// that range fails even though the total free space would fit it.
+static void AllocatorText(const char *name, const FreeListAllocator &allocator, uint32_t capacity, size_t elementSize)
+{
+  const uint32_t free = allocator.freeSize();
+  const uint32_t largest = allocator.largestFreeRange();
+  const double fragmentation = free > 0 ? 1.0 - (double)largest / free : 0.0;
+  ImGui::Text("%s: %.1f / %.1f MiB, %zu free ranges, %.0f%% fragmented", name, (double)(capacity - free) * elementSize / MiB,
+              (double)capacity * elementSize / MiB, allocator.freeRangeCount(), fragmentation * 100.0);
+}
+
+void PerformanceOverlay::Build(Renderer &renderer, VoxelSystem &voxelSystem, const MeshingSystem &meshingSystem, const RenderSystem &renderSystem, const FrameStageTimes &stages)
+{
+  built = false;
+  if (!initialized || !visible)
+    return;
+
+  ImGui_ImplVulkan_NewFrame();
+  ImGui_ImplGlfw_NewFrame();
+  ImGui::NewFrame();
+
+  ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowSize(ImVec2(420.0f, 0.0f), ImGuiCond_FirstUseEver);
+  if (ImGui::Begin("Performance"))
+  {
+    const float latest = frameTimes[(nextFrameTime + HistoryLength - 1) % HistoryLength];
+    const float slowest = *std::max_element(frameTimes.begin(), frameTimes.end());
+    char label[64];
+    snprintf(label, sizeof(label), "%.2f ms (%.0f fps), max %.2f ms", latest, latest > 0.0f ? 1000.0f / latest : 0.0f, slowest);
+    ImGui::PlotLines("##Frame times", frameTimes.data(), (int)HistoryLength, (int)nextFrameTime, label, 0.0f, std::max(slowest, 33.3f), ImVec2(-1.0f, 80.0f));
+
+    if (ImGui::CollapsingHeader("Stages", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+      ImGui::Text("Input       %6.2f ms", stages.input);
+      ImGui::Text("Voxels      %6.2f ms", stages.voxels);
+      ImGui::Text("Meshing     %6.2f ms", stages.meshing);
+      ImGui::Text("Transforms  %6.2f ms", stages.transforms);
+      ImGui::Text("Render      %6.2f ms", stages.render);
+    }
+
+    if (ImGui::CollapsingHeader("Chunks", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+      const auto perLod = voxelSystem.LoadedChunksPerLOD();
+      size_t loaded = 0;
+      for (size_t count : perLod)
+        loaded += count;
+
+      ImGui::Text("Loaded %zu", loaded);
+      for (int lod = 0; lod < CHUNK_LOD_COUNT; lod++)
+      {
+        ImGui::SameLine();
+        ImGui::Text(" LOD%d %zu", lod, perLod[lod]);
+      }
+      ImGui::Text("Generation queue %zu", voxelSystem.QueuedChunkCount());
+      ImGui::Text("Meshed %zu, waiting for data %zu", meshingSystem.stats.meshed, meshingSystem.stats.waiting);
+      ImGui::Text("Uploaded %zu meshes, %.1f KiB", meshingSystem.stats.uploaded, meshingSystem.stats.uploadedBytes / 1024.0);
+    }
+
+    if (ImGui::CollapsingHeader("Geometry and draws", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+      // every greedy quad is 4 vertices and 6 indices
+      const VoxelBuffers &buffers = renderer.voxelBuffers;
+      const uint32_t vertices = MAX_VERTICES - buffers.vertexAlloc.freeSize();
+      const uint32_t indices = MAX_VERTICES - buffers.indexAlloc.freeSize();
+      ImGui::Text("Resident quads %u, triangles %u", vertices / 4, indices / 3);
+      ImGui::Text("Voxel draws %u in 1 indirect call", renderSystem.stats.voxelDraws);
+      ImGui::Text("Mesh draws %u for %u instances", renderSystem.stats.meshDraws, renderSystem.stats.meshInstances);
+    }
+
+    if (ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+      ImGui::Text("Voxel data %.1f MiB", voxelSystem.VoxelMemoryBytes() / MiB);
+      ImGui::Text("Chunk cache %.1f / %.1f MiB, %zu chunks", voxelSystem.chunkCache.MemoryUsage() / MiB,
+                  voxelSystem.chunkCache.GetBudget() / MiB, voxelSystem.chunkCache.Size());
+      ImGui::Text("Device local heap %.0f MiB", deviceLocalHeap / MiB);
+
+      const VoxelBuffers &buffers = renderer.voxelBuffers;
+      AllocatorText("Vertices", buffers.vertexAlloc, MAX_VERTICES, sizeof(VoxelVertex));
+      AllocatorText("Indices", buffers.indexAlloc, MAX_VERTICES, sizeof(uint32_t));
+      AllocatorText("Draw commands", buffers.indirectAlloc, MAX_CHUNKS, sizeof(VkDrawIndexedIndirectCommand));
+    }
+
+    if (ImGui::CollapsingHeader("Tuning"))
+    {
+      WorldComponent &world = voxelSystem.world;
+      glm::ivec3 *radii[CHUNK_LOD_COUNT] = {&world.renderRadius0, &world.renderRadius1, &world.renderRadius2, &world.renderRadius3, &world.renderRadius4};
+      bool radiiChanged = false;
+      for (int lod = 0; lod < CHUNK_LOD_COUNT; lod++)
+      {
+        char name[32];
+        snprintf(name, sizeof(name), "LOD%d radius", lod);
+        radiiChanged |= ImGui::SliderInt3(name, &radii[lod]->x, 0, 64);
+      }
+      if (radiiChanged)
+        voxelSystem.RescanRenderRadii();
+
+      int chunksPerUpdate = (int)voxelSystem.chunksPerUpdate;
+      if (ImGui::SliderInt("Chunks per update", &chunksPerUpdate, 1, 1024))
+        voxelSystem.chunksPerUpdate = (size_t)chunksPerUpdate;
+      ImGui::SliderFloat("LOD priority bias", &voxelSystem.lodPriorityBias, 0.0f, 16.0f);
+      ImGui::SliderInt("LOD hysteresis", &voxelSystem.lodHysteresis, 0, 8);
+
+      int cacheBudget = (int)(voxelSystem.chunkCache.GetBudget() / (size_t)MiB);
+      if (ImGui::SliderInt("Chunk cache MiB", &cacheBudget, 0, 4096))
+        voxelSystem.chunkCache.SetBudget((size_t)cacheBudget * (size_t)MiB);
+    }
+  }
+  ImGui::End();
+
+  ImGui::Render();
+  built = true;
+}
+
+void PerformanceOverlay::Record(VkCommandBuffer commandBuffer)
+{
+  if (built)
+    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+}
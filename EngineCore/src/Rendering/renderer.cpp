@@ -2,6 +2,8 @@
 #include "uniformData.hpp"
 #include "voxelSystem.hpp"
 
+#include <stb_image_write.h>
+
 Renderer::Renderer(GLFWwindow *window) : window(window)
 {
 }
@@ -9,12 +11,22 @@ Renderer::Renderer(GLFWwindow *window) : window(window)
 void Renderer::init()
 {
   instance = createInstance(window);
-  surface = createSurface(instance, window);
+  surface = window ? createSurface(instance, window) : VK_NULL_HANDLE;
   physicalDevice = pickPhysicalDevice(surface, instance);
   device = createLogicalDevice(surface, physicalDevice, instance);
   graphicsQueue = createGraphicsQueue(surface, device, physicalDevice);
   presentQueue = createPresentQueue(surface, device, physicalDevice);
-  swapChainObjects = createSwapChain(device, physicalDevice, surface, window);
+  if (window)
+  {
+    swapChainObjects = createSwapChain(device, physicalDevice, surface, window);
+  }
+  else
+  {
+    // one image per frame in flight, so a frame never draws over one that is still being rendered or copied
+    swapChainObjects = createOffscreenTarget(offscreenExtent, MAX_FRAMES_IN_FLIGHT, device, physicalDevice);
+    createBuffer(offscreenExtent.width * offscreenExtent.height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, captureBuffer, captureBufferMemory, device, physicalDevice);
+    vkMapMemory(device, captureBufferMemory, 0, VK_WHOLE_SIZE, 0, &captureBufferMapped);
+  }
   createImageViews(swapChainObjects, device);
   renderPass = createRenderPass(swapChainObjects, device, physicalDevice);
 
@@ -33,9 +45,9 @@ void Renderer::init()
 
   voxelSetLayout = createDescriptorSetLayout(device, voxelBindings);
 
-  VkPushConstantRange pushConstantRanges = createPushConstantInfo(sizeof(PushConstants), VK_SHADER_STAGE_VERTEX_BIT);
-  std::vector<VkDescriptorSetLayout> setLayouts = {cameraSetLayout, imageSetLayout};
-  pipelineLayout = createPipelineLayout(setLayouts, device, &pushConstantRanges);
+  // mesh instances read their model matrices from a storage buffer with the same layout as the voxel one
+  std::vector<VkDescriptorSetLayout> setLayouts = {cameraSetLayout, imageSetLayout, voxelSetLayout};
+  pipelineLayout = createPipelineLayout(setLayouts, device);
   auto vertexBinding = Vertex::getBindingDescription();
   auto vertexAttributes = Vertex::getAttributeDescriptions();
 
@@ -59,6 +71,15 @@ void Renderer::init()
   createStorageBuffer(storageBufferSize, storageBuffer, storageBufferMemory, storageBufferMapped, device, physicalDevice);
   storageBufferAccess = static_cast<ShaderBufferObject *>(storageBufferMapped);
   createUniformBuffers(uniformBuffers, uniformBuffersMemory, uniformBuffersMapped, device, physicalDevice);
+
+  instanceBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+  instanceBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+  instanceBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+  for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+  {
+    createStorageBuffer(sizeof(ShaderBufferObject) * MAX_MESH_INSTANCES, instanceBuffers[i], instanceBuffersMemory[i], instanceBuffersMapped[i], device, physicalDevice);
+  }
+
   createDescriptorSets();
 
   createEmptyVertexBuffer(voxelBuffers.vertexBufferMemory, voxelBuffers.vertexBuffer, MAX_VERTICES * sizeof(VoxelVertex), commandPool, graphicsQueue, device, physicalDevice);
@@ -114,6 +135,22 @@ void Renderer::createDescriptorSets()
       writeStorageBuffer(voxelSet, 0, &bufferInfo)};
 
   updateDescriptorSets(device, descriptorWrites);
+
+  // mesh instance descriptors
+  allocateDescriptorSets(instanceSets, descriptorPool, voxelSetLayout, device, MAX_FRAMES_IN_FLIGHT);
+
+  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+  {
+    VkDescriptorBufferInfo instanceInfo{};
+    instanceInfo.buffer = instanceBuffers[i];
+    instanceInfo.offset = 0;
+    instanceInfo.range = sizeof(ShaderBufferObject) * MAX_MESH_INSTANCES;
+
+    std::array<VkWriteDescriptorSet, 1> instanceWrites{
+        writeStorageBuffer(instanceSets[i], 0, &instanceInfo)};
+
+    updateDescriptorSets(device, instanceWrites);
+  }
 }
 
 Texture Renderer::createTexutre(const std::string &name, const std::string &filePath)
@@ -197,19 +234,26 @@ void Renderer::startFrame()
 {
   waitForFence(inFlightFences[currentFrame], device);
 
-  VkResult result = acquireNextImageIndex(imageIndex, imageAvailableSemaphores[currentFrame], swapChainObjects.swapChain, device);
-  if (result == VK_ERROR_OUT_OF_DATE_KHR)
+  if (!window)
   {
-    recreateSwapChain(commandPool, graphicsQueue, renderPass, swapChainObjects, device, physicalDevice, surface, window);
-    return; // stop drawing the frame if the swapchain is out of date
+    imageIndex = currentFrame; // offscreen images are never out of date
   }
-  else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+  else
   {
-    std::cerr << "Failed to acquire swap chain image!" << std::endl;
-    glfwTerminate();
-    std::cerr << "Press Enter to exit..." << std::endl;
-    std::cin.get();
-    exit(EXIT_FAILURE);
+    VkResult result = acquireNextImageIndex(imageIndex, imageAvailableSemaphores[currentFrame], swapChainObjects.swapChain, device);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+      recreateSwapChain(commandPool, graphicsQueue, renderPass, swapChainObjects, device, physicalDevice, surface, window);
+      return; // stop drawing the frame if the swapchain is out of date
+    }
+    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    {
+      std::cerr << "Failed to acquire swap chain image!" << std::endl;
+      glfwTerminate();
+      std::cerr << "Press Enter to exit..." << std::endl;
+      std::cin.get();
+      exit(EXIT_FAILURE);
+    }
   }
 
   resetFence(inFlightFences[currentFrame], device);
@@ -220,6 +264,12 @@ void Renderer::startFrame()
 
 void Renderer::endFrame()
 {
+  if (!window)
+  {
+    endOffscreenFrame();
+    return;
+  }
+
   endRendering();
 
   submitFrame(imageAvailableSemaphores[currentFrame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, renderFinishedSemaphores[imageIndex], inFlightFences[currentFrame], commandBuffers[currentFrame], graphicsQueue);
@@ -242,6 +292,57 @@ void Renderer::endFrame()
   currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
+void Renderer::endOffscreenFrame()
+{
+  bool capture = !capturePath.empty();
+
+  endRenderPass(commandBuffers[currentFrame]);
+  if (capture)
+  {
+    recordImageToBufferCopy(commandBuffers[currentFrame], swapChainObjects.swapChainImages[imageIndex], captureBuffer, swapChainObjects.swapChainExtent.width, swapChainObjects.swapChainExtent.height);
+  }
+  endCommandBuffer(commandBuffers[currentFrame]);
+
+  submitFrame(VK_NULL_HANDLE, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_NULL_HANDLE, inFlightFences[currentFrame], commandBuffers[currentFrame], graphicsQueue);
+
+  if (capture)
+  {
+    waitForFence(inFlightFences[currentFrame], device);
+    writeCapture();
+  }
+
+  currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+void Renderer::captureFrame(const std::string &path)
+{
+  if (window)
+  {
+    std::cerr << "Frame captures need a headless renderer! File: " << path << std::endl;
+    return;
+  }
+  capturePath = path;
+}
+
+void Renderer::writeCapture()
+{
+  const uint32_t width = swapChainObjects.swapChainExtent.width;
+  const uint32_t height = swapChainObjects.swapChainExtent.height;
+
+  // the alpha channel holds whatever the shaders wrote, make it opaque so images diff on color alone
+  std::vector<uint8_t> pixels(static_cast<uint8_t *>(captureBufferMapped), static_cast<uint8_t *>(captureBufferMapped) + width * height * 4);
+  for (size_t i = 3; i < pixels.size(); i += 4)
+  {
+    pixels[i] = 255;
+  }
+
+  if (!stbi_write_png(capturePath.c_str(), width, height, 4, pixels.data(), width * 4))
+  {
+    std::cerr << "Failed to write frame capture! File: " << capturePath << std::endl;
+  }
+  capturePath.clear();
+}
+
 void Renderer::startRendering(uint32_t imageIndex)
 {
   beginCommandBuffer(commandBuffers[currentFrame]);
@@ -265,13 +366,28 @@ void Renderer::cleanup()
 
   destroyStorageBuffer(storageBuffer, storageBufferMemory, device);
 
+  for (size_t i = 0; i < instanceBuffers.size(); i++)
+  {
+    destroyStorageBuffer(instanceBuffers[i], instanceBuffersMemory[i], device);
+  }
+  instanceBuffers.clear();
+  instanceBuffersMemory.clear();
+  instanceBuffersMapped.clear();
+
   vkFreeDescriptorSets(device, descriptorPool, static_cast<uint32_t>(cameraSets.size()), cameraSets.data());
   vkFreeDescriptorSets(device, descriptorPool, 1, &voxelSet);
+  vkFreeDescriptorSets(device, descriptorPool, static_cast<uint32_t>(instanceSets.size()), instanceSets.data());
 
   destroyBuffer(voxelBuffers.indexBufferMemory, voxelBuffers.indexBuffer, device);
   destroyBuffer(voxelBuffers.vertexBufferMemory, voxelBuffers.vertexBuffer, device);
   destroyBuffer(voxelBuffers.indirectBufferMemory, voxelBuffers.indirectBuffer, device);
 
+  if (captureBuffer != VK_NULL_HANDLE)
+  {
+    vkUnmapMemory(device, captureBufferMemory);
+    destroyBuffer(captureBufferMemory, captureBuffer, device);
+  }
+
   for (auto fence : inFlightFences)
   {
     destroyFence(fence, device);
@@ -3,6 +3,7 @@
 #include "uniformData.hpp"
 #include <cstring>
 #include "vulkanBufferUtils.hpp"
+#include "profiler.hpp"
 #include "camera.hpp"
 
 VoxelMesh::VoxelMesh(Renderer &renderer) : renderer(renderer)
@@ -11,6 +12,7 @@ VoxelMesh::VoxelMesh(Renderer &renderer) : renderer(renderer)
 
 void VoxelMesh::Init(Texture texture, const std::vector<VoxelVertex> &verts, const std::vector<uint32_t> &inds, uint32_t gpuIndex)
 {
+  PROFILE_ZONE("VoxelMesh::Init");
   this->texture = texture;
   vertices = verts;
   indices = inds;
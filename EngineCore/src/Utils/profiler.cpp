@@ -0,0 +1,172 @@
+#include "profiler.hpp"
+#include "threadPool.hpp"
+#include "json.hpp"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Profiler::recording{false};
+
+namespace
+{
+  enum class EventType : uint8_t
+  {
+    Zone,
+    Frame,
+    Counter,
+  };
+
+  struct Event
+  {
+    const char *name;
+    uint64_t start;
+    uint64_t end;  // zones only
+    double value;  // counter value, or the frame number of a frame mark
+    EventType type;
+  };
+
+  // Written by its thread only. The count is published after the event so the exporter never reads
+  // an event that is still being filled in, older events are overwritten once the ring is full.
+  struct ThreadBuffer
+  {
+    static constexpr uint64_t Capacity = 1 << 16;
+
+    std::vector<Event> events = std::vector<Event>(Capacity);
+    std::atomic<uint64_t> count{0};
+    uint32_t id;
+    std::string name;
+
+    void Push(const Event &event)
+    {
+      const uint64_t index = count.load(std::memory_order_relaxed);
+      events[index & (Capacity - 1)] = event;
+      count.store(index + 1, std::memory_order_release);
+    }
+  };
+
+  std::mutex buffersMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers; // never freed, threads that exit keep their events
+  std::atomic<uint64_t> frameNumber{0};
+  thread_local ThreadBuffer *threadBuffer = nullptr;
+
+  ThreadBuffer &CurrentBuffer()
+  {
+    if (threadBuffer)
+      return *threadBuffer;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->id = (uint32_t)buffers.size();
+    const unsigned int poolIndex = ThreadPool::CurrentThreadIndex();
+    buffer->name = poolIndex > 0 ? "Worker " + std::to_string(poolIndex) : "Thread " + std::to_string(buffer->id);
+    threadBuffer = buffer.get();
+    buffers.push_back(std::move(buffer));
+    return *threadBuffer;
+  }
+}
+
+uint64_t Profiler::Now()
+{
+  static const auto epoch = std::chrono::steady_clock::now();
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::Start()
+{
+  {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto &buffer : buffers)
+      buffer->count.store(0, std::memory_order_relaxed);
+  }
+  frameNumber = 0;
+  recording = true;
+}
+
+void Profiler::Stop()
+{
+  recording = false;
+}
+
+void Profiler::FrameMark()
+{
+  if (!IsRecording())
+    return;
+  const uint64_t now = Now();
+  CurrentBuffer().Push({"Frame", now, now, (double)frameNumber++, EventType::Frame});
+}
+
+void Profiler::Counter(const char *name, double value)
+{
+  const uint64_t now = Now();
+  CurrentBuffer().Push({name, now, now, value, EventType::Counter});
+}
+
+void Profiler::RecordZone(const char *name, uint64_t start, uint64_t end)
+{
+  CurrentBuffer().Push({name, start, end, 0.0, EventType::Zone});
+}
+
+void Profiler::SetThreadName(const std::string &name)
+{
+  ThreadBuffer &buffer = CurrentBuffer();
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  buffer.name = name;
+}
+
+bool Profiler::WriteChromeTrace(const std::string &path, uint64_t from, uint64_t to)
+{
+  nlohmann::json events = nlohmann::json::array();
+  uint64_t dropped = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const auto &buffer : buffers)
+    {
+      const uint64_t count = buffer->count.load(std::memory_order_acquire);
+      if (count == 0)
+        continue;
+
+      events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 0}, {"tid", buffer->id}, {"args", {{"name", buffer->name}}}});
+
+      const uint64_t first = count > ThreadBuffer::Capacity ? count - ThreadBuffer::Capacity : 0;
+      dropped += first;
+      for (uint64_t i = first; i < count; i++)
+      {
+        const Event &event = buffer->events[i & (ThreadBuffer::Capacity - 1)];
+        if (event.end < from || event.start > to)
+          continue;
+
+        const double timestamp = event.start / 1000.0; // trace timestamps are in microseconds
+
+        switch (event.type)
+        {
+        case EventType::Zone:
+          events.push_back({{"name", event.name}, {"ph", "X"}, {"pid", 0}, {"tid", buffer->id}, {"ts", timestamp}, {"dur", (event.end - event.start) / 1000.0}});
+          break;
+        case EventType::Frame:
+          events.push_back({{"name", event.name}, {"ph", "i"}, {"s", "g"}, {"pid", 0}, {"tid", buffer->id}, {"ts", timestamp}, {"args", {{"frame", (uint64_t)event.value}}}});
+          break;
+        case EventType::Counter:
+          events.push_back({{"name", event.name}, {"ph", "C"}, {"pid", 0}, {"tid", buffer->id}, {"ts", timestamp}, {"args", {{"value", event.value}}}});
+          break;
+        }
+      }
+    }
+  }
+
+  std::ofstream file(path);
+  if (!file.is_open())
+  {
+    std::cerr << "Failed to open profiler trace! File: " << path << std::endl;
+    return false;
+  }
+
+  nlohmann::json trace;
+  trace["traceEvents"] = std::move(events);
+  trace["displayTimeUnit"] = "ms";
+  trace["droppedEvents"] = dropped; // overwritten in full ring buffers
+  file << trace.dump();
+  return true;
+}
@@ -0,0 +1,110 @@
+#include "stutterDetector.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+void FrameTimeHistogram::Add(double ms)
+{
+  const size_t bucket = std::min((size_t)std::max(ms / BucketMs, 0.0), BucketCount - 1);
+  buckets[bucket]++;
+  count++;
+  max = std::max(max, ms);
+}
+
+void FrameTimeHistogram::Reset()
+{
+  buckets.fill(0);
+  count = 0;
+  max = 0.0;
+}
+
+double FrameTimeHistogram::Percentile(double p) const
+{
+  if (count == 0)
+    return 0.0;
+
+  const uint64_t rank = std::max<uint64_t>((uint64_t)(p * count + 0.5), 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BucketCount; i++)
+  {
+    seen += buckets[i];
+    if (seen >= rank)
+      return std::min((i + 1) * BucketMs, max);
+  }
+  return max;
+}
+
+void StutterDetector::Start()
+{
+  Profiler::Start();
+  frameStarts.clear();
+  frame = 0;
+  pending = false;
+}
+
+void StutterDetector::FrameBoundary()
+{
+  const uint64_t now = Profiler::Now();
+  PROFILE_FRAME();
+
+  // frames are numbered by the boundary they start at, the one ending now started at the last one
+  if (frame > 0 && !skipFrame)
+  {
+    const uint64_t ended = frame - 1;
+    const double ms = (now - lastBoundary) / 1e6;
+    histogram.Add(ms);
+
+    if (ms > thresholdMs)
+    {
+      stutters++;
+      if (!pending && tracesWritten < maxTraces)
+      {
+        // the slow frame is the newest start kept, the oldest is up to framesAround frames before it
+        pending = true;
+        pendingTrace = {ended, ms, frameStarts.front(), ended + 1 - frameStarts.size(), ended + framesAround};
+      }
+    }
+  }
+  skipFrame = false;
+
+  if (pending && frame > 0 && frame - 1 >= pendingTrace.lastFrame)
+  {
+    pending = false;
+    WriteTrace(pendingTrace, now);
+  }
+
+  frame++;
+  frameStarts.push_back(now);
+  while (frameStarts.size() > (size_t)framesAround + 1)
+    frameStarts.pop_front();
+  lastBoundary = now;
+}
+
+void StutterDetector::WriteTrace(const PendingTrace &trace, uint64_t to)
+{
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error)
+  {
+    std::cerr << "Failed to create stutter trace directory! Directory: " << directory << " (" << error.message() << ")" << std::endl;
+    return;
+  }
+
+  const std::string path = (std::filesystem::path(directory) / ("stutter_" + std::to_string(trace.frame) + ".json")).string();
+  if (!Profiler::WriteChromeTrace(path, trace.from, to))
+    return;
+
+  tracesWritten++;
+  skipFrame = true;
+  printf("Stutter: frame %llu took %.2f ms, frames %llu-%llu written to %s\n", (unsigned long long)trace.frame, trace.ms,
+         (unsigned long long)trace.firstFrame, (unsigned long long)trace.lastFrame, path.c_str());
+}
+
+bool StutterDetector::WriteRecent(const std::string &path)
+{
+  skipFrame = true;
+  return Profiler::WriteChromeTrace(path);
+}
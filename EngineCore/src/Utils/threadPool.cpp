@@ -0,0 +1,176 @@
+#include "threadPool.hpp"
+#include <algorithm>
+
+static thread_local unsigned int currentThreadIndex = 0;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+  Start(threadCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+  Stop();
+}
+
+void ThreadPool::SetThreadCount(unsigned int threadCount)
+{
+  if (threadCount == workers.size() && !queues.empty())
+    return;
+
+  Stop();
+  Start(threadCount);
+}
+
+void ThreadPool::Start(unsigned int threadCount)
+{
+  queues.clear();
+  for (unsigned int i = 0; i <= threadCount; i++)
+    queues.push_back(std::make_unique<WorkQueue>());
+
+  running = true;
+  workers.reserve(threadCount);
+  for (unsigned int i = 1; i <= threadCount; i++)
+    workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+void ThreadPool::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    running = false;
+  }
+  wakeCondition.notify_all();
+
+  for (auto &worker : workers)
+    worker.join();
+  workers.clear();
+}
+
+unsigned int ThreadPool::CurrentThreadIndex()
+{
+  return currentThreadIndex;
+}
+
+void ThreadPool::Submit(Task task)
+{
+  if (workers.empty())
+  {
+    task();
+    return;
+  }
+
+  unsigned int index = currentThreadIndex < queues.size() ? currentThreadIndex : 0;
+  {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    ++queuedTasks;
+    queues[index]->tasks.push_back(std::move(task));
+  }
+
+  // taking the sleep mutex orders the notify after any worker that is about to wait
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+  }
+  wakeCondition.notify_one();
+}
+
+bool ThreadPool::PopLocal(unsigned int index, Task &task)
+{
+  WorkQueue &queue = *queues[index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+    return false;
+
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool ThreadPool::Steal(unsigned int index, Task &task)
+{
+  const size_t count = queues.size();
+  for (size_t i = 1; i < count; i++)
+  {
+    WorkQueue &victim = *queues[(index + i) % count];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.tasks.empty())
+      continue;
+
+    task = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+bool ThreadPool::TryRunTask(unsigned int index)
+{
+  Task task;
+  if (!PopLocal(index, task) && !Steal(index, task))
+    return false;
+
+  --queuedTasks;
+  task();
+  return true;
+}
+
+void ThreadPool::WorkerLoop(unsigned int index)
+{
+  currentThreadIndex = index;
+
+  while (true)
+  {
+    if (TryRunTask(index))
+      continue;
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wakeCondition.wait(lock, [this]
+                       { return !running || queuedTasks > 0; });
+
+    if (!running && queuedTasks == 0)
+      return;
+  }
+}
+
+void ThreadPool::Wait(const std::atomic<uint32_t> &pending)
+{
+  unsigned int index = currentThreadIndex < queues.size() ? currentThreadIndex : 0;
+
+  while (pending > 0)
+  {
+    if (!TryRunTask(index))
+      std::this_thread::yield();
+  }
+}
+
+bool ThreadPool::RunTask()
+{
+  return TryRunTask(currentThreadIndex < queues.size() ? currentThreadIndex : 0);
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &fn)
+{
+  if (count == 0)
+    return;
+
+  grainSize = std::max<size_t>(grainSize, 1);
+
+  if (workers.empty() || count <= grainSize)
+  {
+    for (size_t begin = 0; begin < count; begin += grainSize)
+      fn(begin, std::min(begin + grainSize, count));
+    return;
+  }
+
+  std::atomic<uint32_t> pending{static_cast<uint32_t>((count + grainSize - 1) / grainSize)};
+  for (size_t begin = 0; begin < count; begin += grainSize)
+  {
+    size_t end = std::min(begin + grainSize, count);
+    Submit([&fn, &pending, begin, end]
+           {
+             fn(begin, end);
+             --pending; });
+  }
+
+  Wait(pending);
+}
@@ -0,0 +1,141 @@
+#include "biomeIndex.hpp"
+#include <algorithm>
+#include <limits>
+
+void BiomeIndex::Build(const std::vector<Point> &points, int resolution)
+{
+  count = points.size();
+  for (int d = 0; d < Dimensions; d++)
+  {
+    coords[d].resize(count);
+    for (size_t id = 0; id < count; id++)
+      coords[d][id] = points[id][d];
+  }
+
+  cellStart.clear();
+  cellCandidates.clear();
+  this->resolution = count >= MinGridBiomes ? resolution : 0;
+  if (this->resolution == 0)
+    return;
+
+  size_t cells = 1;
+  for (int d = 0; d < Dimensions; d++)
+    cells *= this->resolution;
+
+  // cells are grown slightly so a query rounded into a neighbouring cell is still covered
+  const float cellSize = 1.0f / this->resolution;
+  const float margin = cellSize * 1e-3f;
+
+  std::vector<float> minDistances(count);
+  cellStart.resize(cells + 1);
+
+  for (size_t cell = 0; cell < cells; cell++)
+  {
+    float lo[Dimensions], hi[Dimensions];
+    size_t rest = cell;
+    for (int d = 0; d < Dimensions; d++)
+    {
+      int k = static_cast<int>(rest % this->resolution);
+      rest /= this->resolution;
+      lo[d] = k * cellSize - margin;
+      hi[d] = (k + 1) * cellSize + margin;
+    }
+
+    // a biome can only be nearest somewhere in the cell if its closest approach to the cell beats
+    // the furthest any biome can be from it
+    float bestFarthest = std::numeric_limits<float>::max();
+    for (size_t id = 0; id < count; id++)
+    {
+      float nearest = 0.0f, farthest = 0.0f;
+      for (int d = 0; d < Dimensions; d++)
+      {
+        float x = points[id][d];
+        float outside = x < lo[d] ? lo[d] - x : (x > hi[d] ? x - hi[d] : 0.0f);
+        float across = std::max(x - lo[d], hi[d] - x);
+        nearest += outside * outside;
+        farthest += across * across;
+      }
+      minDistances[id] = nearest;
+      bestFarthest = std::min(bestFarthest, farthest);
+    }
+
+    // a little slack so float rounding can only add candidates, never drop the right one
+    const float limit = bestFarthest * 1.0001f + 1e-6f;
+
+    cellStart[cell] = static_cast<uint32_t>(cellCandidates.size());
+    for (size_t id = 0; id < count; id++)
+    {
+      if (minDistances[id] <= limit)
+        cellCandidates.push_back(static_cast<uint16_t>(id));
+    }
+  }
+  cellStart[cells] = static_cast<uint32_t>(cellCandidates.size());
+}
+
+float BiomeIndex::Distance(uint32_t id, const Point &query) const
+{
+  float distance = 0.0f;
+  for (int d = 0; d < Dimensions; d++)
+  {
+    float delta = coords[d][id] - query[d];
+    distance += delta * delta;
+  }
+  return distance;
+}
+
+int BiomeIndex::Nearest(const Point &query) const
+{
+  if (resolution == 0)
+    return NearestLinear(query);
+
+  size_t cell = 0;
+  size_t stride = 1;
+  for (int d = 0; d < Dimensions; d++)
+  {
+    // features outside the unit cube are rare enough to just scan everything
+    if (!(query[d] >= 0.0f && query[d] <= 1.0f))
+      return NearestLinear(query);
+
+    int k = std::min(static_cast<int>(query[d] * resolution), resolution - 1);
+    cell += k * stride;
+    stride *= resolution;
+  }
+
+  // candidates are stored in id order, so a strict compare keeps the lowest id on ties
+  int bestId = -1;
+  float bestDistance = std::numeric_limits<float>::max();
+  for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; i++)
+  {
+    float distance = Distance(cellCandidates[i], query);
+    if (distance < bestDistance)
+    {
+      bestDistance = distance;
+      bestId = cellCandidates[i];
+    }
+  }
+  return bestId;
+}
+
+int BiomeIndex::NearestLinear(const Point &query) const
+{
+  int bestId = -1;
+  float bestDistance = std::numeric_limits<float>::max();
+  for (size_t id = 0; id < count; id++)
+  {
+    float distance = Distance(static_cast<uint32_t>(id), query);
+    if (distance < bestDistance)
+    {
+      bestDistance = distance;
+      bestId = static_cast<int>(id);
+    }
+  }
+  return bestId;
+}
+
+float BiomeIndex::AverageCandidates() const
+{
+  if (resolution == 0)
+    return static_cast<float>(count);
+
+  return static_cast<float>(cellCandidates.size()) / (cellStart.size() - 1);
+}
@@ -0,0 +1,130 @@
+#include "chunkCache.hpp"
+#include "voxelCodec.hpp"
+
+void ChunkCache::SetBudget(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  budget = bytes;
+  EvictLocked();
+}
+
+void ChunkCache::Store(const glm::ivec3 &coord, int lod, const std::vector<Voxel> &voxels)
+{
+  if (voxels.empty())
+    return;
+
+  // encoded before taking the lock, the worker threads store and take entries concurrently
+  Entry entry{coord, lod, {}};
+  EncodeVoxels(voxels, entry.data);
+  entry.data.shrink_to_fit();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  EraseLocked(coord);
+  if (entry.Bytes() > budget)
+    return;
+
+  usage += entry.Bytes();
+  entries.push_front(std::move(entry));
+  lookup[coord] = entries.begin();
+  EvictLocked();
+}
+
+bool ChunkCache::Take(const glm::ivec3 &coord, int maxLod, std::vector<Voxel> &voxels, int &lod)
+{
+  Entry entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = lookup.find(coord);
+    if (it == lookup.end() || it->second->lod > maxLod)
+    {
+      misses++;
+      return false;
+    }
+
+    entry = std::move(*it->second);
+    usage -= entry.Bytes();
+    entries.erase(it->second);
+    lookup.erase(it);
+  }
+
+  if (!DecodeVoxels(entry.data.data(), entry.data.size(), voxels))
+  {
+    voxels.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    misses++;
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    hits++;
+  }
+  lod = entry.lod;
+  return true;
+}
+
+void ChunkCache::Erase(const glm::ivec3 &coord)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  EraseLocked(coord);
+}
+
+void ChunkCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.clear();
+  lookup.clear();
+  usage = 0;
+}
+
+size_t ChunkCache::Size()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
+
+size_t ChunkCache::MemoryUsage()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return usage;
+}
+
+uint64_t ChunkCache::Hits()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return hits;
+}
+
+uint64_t ChunkCache::Misses()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return misses;
+}
+
+float ChunkCache::HitRate()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  const uint64_t lookups = hits + misses;
+  return lookups > 0 ? (float)hits / lookups : 0.0f;
+}
+
+void ChunkCache::EraseLocked(const glm::ivec3 &coord)
+{
+  auto it = lookup.find(coord);
+  if (it == lookup.end())
+    return;
+
+  usage -= it->second->Bytes();
+  entries.erase(it->second);
+  lookup.erase(it);
+}
+
+void ChunkCache::EvictLocked()
+{
+  while (usage > budget && !entries.empty())
+  {
+    usage -= entries.back().Bytes();
+    lookup.erase(entries.back().coord);
+    entries.pop_back();
+  }
+}
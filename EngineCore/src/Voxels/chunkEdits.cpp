@@ -0,0 +1,75 @@
+#include "chunkEdits.hpp"
+#include "voxelCodec.hpp"
+#include <algorithm>
+
+static const int SIZE = CHUNK_SIZE;
+
+void ChunkEdits::Set(uint16_t index, uint32_t type)
+{
+  auto it = std::lower_bound(edits.begin(), edits.end(), index, [](const Edit &edit, uint16_t i)
+                             { return edit.index < i; });
+  if (it != edits.end() && it->index == index)
+    it->type = type;
+  else
+    edits.insert(it, {index, type});
+}
+
+void ChunkEdits::Apply(std::vector<Voxel> &voxels, int lod) const
+{
+  const int step = 1 << lod;
+  const int resolution = SIZE / step;
+
+  for (const Edit &edit : edits)
+  {
+    // voxelData rows are the lod's samples in order, so row r at full resolution is sample r / step
+    const int x = edit.index % SIZE;
+    const int z = (edit.index / SIZE) % SIZE;
+    const int row = edit.index / (SIZE * SIZE);
+    if (x % step != 0 || z % step != 0 || row % step != 0)
+      continue;
+    if (x / step >= resolution || z / step >= resolution || row / step >= resolution)
+      continue;
+
+    voxels[x / step + resolution * (z / step + resolution * (row / step))].type = edit.type;
+  }
+}
+
+void ChunkEdits::Encode(std::vector<uint8_t> &out) const
+{
+  out.clear();
+  WriteVarint(out, edits.size());
+
+  uint16_t previous = 0;
+  for (const Edit &edit : edits)
+  {
+    WriteVarint(out, edit.index - previous);
+    WriteVarint(out, edit.type);
+    previous = edit.index;
+  }
+}
+
+bool ChunkEdits::Decode(const uint8_t *data, size_t size)
+{
+  const uint8_t *end = data + size;
+  edits.clear();
+
+  uint64_t count;
+  if (!ReadVarint(data, end, count) || count > (uint64_t)SIZE * SIZE * SIZE)
+    return false;
+
+  edits.reserve(count);
+  uint64_t index = 0;
+  for (uint64_t i = 0; i < count; i++)
+  {
+    uint64_t gap, type;
+    if (!ReadVarint(data, end, gap) || !ReadVarint(data, end, type))
+      return false;
+
+    index += gap;
+    if (index >= (uint64_t)SIZE * SIZE * SIZE || (i > 0 && gap == 0))
+      return false;
+    edits.push_back({(uint16_t)index, (uint32_t)type});
+  }
+
+  return data == end;
+}
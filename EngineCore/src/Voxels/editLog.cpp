@@ -0,0 +1,153 @@
+#include "editLog.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+EditLog::~EditLog()
+{
+  Close();
+}
+
+bool EditLog::Open(const std::string &path, std::unordered_map<glm::ivec3, ChunkEdits, IVec3Hash> &edits)
+{
+  Close();
+  this->path = path;
+
+  std::error_code error;
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+  std::vector<char> contents;
+  {
+    std::ifstream input(path, std::ios::ate | std::ios::binary);
+    if (input.is_open())
+    {
+      contents.resize((size_t)input.tellg());
+      input.seekg(0);
+      input.read(contents.data(), contents.size());
+    }
+  }
+
+  uint32_t header[2] = {};
+  if (contents.size() < sizeof(header))
+    return Rewrite(edits); // new save
+
+  std::memcpy(header, contents.data(), sizeof(header));
+  if (header[0] != Magic || header[1] != Version)
+  {
+    std::cerr << "Invalid edit log, edits will not be saved! File: " << path << std::endl;
+    return false;
+  }
+
+  size_t offset = sizeof(header);
+  size_t records = 0;
+  bool truncated = false;
+  while (offset < contents.size())
+  {
+    RecordHeader record;
+    if (contents.size() - offset < sizeof(RecordHeader))
+    {
+      truncated = true;
+      break;
+    }
+    std::memcpy(&record, contents.data() + offset, sizeof(RecordHeader));
+    offset += sizeof(RecordHeader);
+
+    ChunkEdits chunkEdits;
+    if (contents.size() - offset < record.length ||
+        !chunkEdits.Decode(reinterpret_cast<const uint8_t *>(contents.data() + offset), record.length))
+    {
+      truncated = true;
+      break;
+    }
+    offset += record.length;
+
+    edits[glm::ivec3(record.x, record.y, record.z)] = std::move(chunkEdits);
+    records++;
+  }
+
+  // superseded records are dead weight, drop them once they outnumber the live ones
+  if (truncated || records > 2 * edits.size())
+    return Rewrite(edits);
+
+  file = std::fopen(path.c_str(), "ab");
+  if (!file)
+  {
+    std::cerr << "Failed to open edit log! File: " << path << std::endl;
+    return false;
+  }
+  fileSize = contents.size();
+  return true;
+}
+
+void EditLog::Close()
+{
+  if (file)
+    std::fclose(file);
+  file = nullptr;
+  fileSize = 0;
+}
+
+bool EditLog::Append(const glm::ivec3 &coord, const ChunkEdits &edits)
+{
+  if (!file)
+    return false;
+
+  std::vector<uint8_t> data;
+  edits.Encode(data);
+
+  RecordHeader record{coord.x, coord.y, coord.z, (uint32_t)data.size()};
+  bool written = std::fwrite(&record, sizeof(RecordHeader), 1, file) == 1 &&
+                 std::fwrite(data.data(), 1, data.size(), file) == data.size() &&
+                 std::fflush(file) == 0;
+  if (!written)
+  {
+    std::cerr << "Failed to append to edit log! File: " << path << std::endl;
+    return false;
+  }
+
+  fileSize += sizeof(RecordHeader) + data.size();
+  return true;
+}
+
+bool EditLog::Rewrite(const std::unordered_map<glm::ivec3, ChunkEdits, IVec3Hash> &edits)
+{
+  // written next to the log and renamed over it, so the old log stays intact until the new one is complete
+  const std::string temporary = path + ".tmp";
+  file = std::fopen(temporary.c_str(), "wb");
+  if (!file)
+  {
+    std::cerr << "Failed to create edit log! File: " << temporary << std::endl;
+    return false;
+  }
+
+  const uint32_t header[2] = {Magic, Version};
+  std::fwrite(header, sizeof(header), 1, file);
+  fileSize = sizeof(header);
+
+  for (const auto &[coord, chunkEdits] : edits)
+  {
+    if (!Append(coord, chunkEdits))
+    {
+      Close();
+      return false;
+    }
+  }
+  std::fclose(file);
+  file = nullptr;
+
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error)
+  {
+    std::cerr << "Failed to replace edit log! File: " << path << " (" << error.message() << ")" << std::endl;
+    return false;
+  }
+
+  const uint64_t size = fileSize;
+  file = std::fopen(path.c_str(), "ab");
+  fileSize = size;
+  return file != nullptr;
+}
@@ -1,5 +1,6 @@
 #include "meshingSystem.hpp"
 #include "renderer.hpp"
+#include "profiler.hpp"
 
 void EmitQuad(std::vector<VoxelVertex> &vertices, std::vector<uint32_t> &indices, glm::ivec3 pos, glm::ivec3 size, int axis, bool backFace, uint16_t texture, int step)
 {
@@ -101,27 +102,24 @@ void EmitQuad(std::vector<VoxelVertex> &vertices, std::vector<uint32_t> &indices
   }
 }
 
-int Index3D(int x, int y, int z)
+// voxel data is stored at the chunk's lod resolution, so x, y, z are sample coordinates
+int Index3D(int x, int y, int z, int resolution)
 {
-  return x + CHUNK_SIZE * z + CHUNK_SIZE * CHUNK_SIZE * y;
+  return x + resolution * z + resolution * resolution * y;
 }
 
 bool IsSolid(const std::vector<Voxel> &voxels,
              const BlockRegistry &registry,
              int x, int y, int z,
-             int step)
+             int resolution)
 {
   if (x < 0 || y < 0 || z < 0 ||
-      x >= CHUNK_SIZE / step ||
-      y >= CHUNK_SIZE / step ||
-      z >= CHUNK_SIZE / step)
+      x >= resolution ||
+      y >= resolution ||
+      z >= resolution)
     return false;
 
-  int sx = x * step;
-  int sy = y * step;
-  int sz = z * step;
-
-  uint32_t type = voxels[Index3D(sx, sy, sz)].type;
+  uint32_t type = voxels[Index3D(x, y, z, resolution)].type;
   return registry.blocks[type].visible;
 }
 
@@ -132,6 +130,9 @@ void MeshingSystem::Init(std::shared_ptr<Coordinator> coordinator)
 
 void MeshingSystem::Update(Texture voxelTextures, Renderer &renderer)
 {
+  PROFILE_ZONE("MeshingSystem::Update");
+  stats = {};
+  std::vector<Entity> dirtyChunks;
   for (auto &e : mEntities)
   {
     if (!gCoordinator->HasComponent<ChunkComponent>(e))
@@ -140,29 +141,78 @@ void MeshingSystem::Update(Texture voxelTextures, Renderer &renderer)
     }
 
     auto &chunk = gCoordinator->GetComponent<ChunkComponent>(e);
+
+    // a chunk promoted to a finer lod keeps its old samples until it is regenerated
+    const size_t resolution = chunk.Resolution();
+    if (chunk.voxelData.size() != resolution * resolution * resolution)
+    {
+      if (chunk.chunkState == ChunkState::NeedsMeshing)
+        stats.waiting++;
+      continue;
+    }
+
     if (chunk.chunkState == ChunkState::NeedsMeshing)
     {
-      CreateMesh(voxelTextures, renderer, e);
-      chunk.chunkState = ChunkState::Clean;
+      chunk.chunkState = ChunkState::Meshing;
+      dirtyChunks.push_back(e);
     }
   }
+
+  stats.meshed = dirtyChunks.size();
+  PROFILE_COUNTER("Chunks meshed", stats.meshed);
+
+  // meshing only reads voxel data so it runs across the worker threads, uploads stay on this thread
+  std::vector<std::vector<VoxelVertex>> vertices(dirtyChunks.size());
+  std::vector<std::vector<uint32_t>> indices(dirtyChunks.size());
+  gCoordinator->ParallelFor(dirtyChunks.size(), 1, [&](size_t begin, size_t end)
+                            {
+                              for (size_t i = begin; i < end; i++)
+                                BuildMesh(dirtyChunks[i], vertices[i], indices[i]); });
+
+  for (size_t i = 0; i < dirtyChunks.size(); i++)
+  {
+    UploadMesh(voxelTextures, renderer, dirtyChunks[i], vertices[i], indices[i]);
+    gCoordinator->GetComponent<ChunkComponent>(dirtyChunks[i]).chunkState = ChunkState::Clean;
+
+    if (vertices[i].size() > 0 && indices[i].size() > 0)
+    {
+      stats.uploaded++;
+      stats.uploadedBytes += vertices[i].size() * sizeof(VoxelVertex) + indices[i].size() * sizeof(uint32_t);
+    }
+  }
+
+  PROFILE_COUNTER("Chunks uploaded", stats.uploaded);
+  PROFILE_COUNTER("Bytes uploaded", stats.uploadedBytes);
+  PROFILE_COUNTER("Free vertex slots", renderer.voxelBuffers.vertexAlloc.freeSize());
+  PROFILE_COUNTER("Largest free vertex range", renderer.voxelBuffers.vertexAlloc.largestFreeRange());
+  PROFILE_COUNTER("Vertex free ranges", renderer.voxelBuffers.vertexAlloc.freeRangeCount());
+  PROFILE_COUNTER("Free index slots", renderer.voxelBuffers.indexAlloc.freeSize());
+  PROFILE_COUNTER("Free draw slots", renderer.voxelBuffers.indirectAlloc.freeSize());
 }
 
 void MeshingSystem::CreateMesh(Texture voxelTextures, Renderer &renderer, Entity chunkEntity)
 {
+  PROFILE_ZONE("MeshingSystem::CreateMesh");
+  std::vector<VoxelVertex> vertices;
+  std::vector<uint32_t> indices;
+  BuildMesh(chunkEntity, vertices, indices);
+  UploadMesh(voxelTextures, renderer, chunkEntity, vertices, indices);
+}
+
+void MeshingSystem::BuildMesh(Entity chunkEntity, std::vector<VoxelVertex> &vertices, std::vector<uint32_t> &indices)
+{
+  PROFILE_ZONE("MeshingSystem::BuildMesh");
   auto &chunk = gCoordinator->GetComponent<ChunkComponent>(chunkEntity);
   const int step = 1 << chunk.chunkLOD; // step doubles for each lod
 
-  const int W = CHUNK_SIZE / step;
-  const int H = CHUNK_SIZE / step;
-  const int D = CHUNK_SIZE / step;
+  const int resolution = chunk.Resolution();
+  const int W = resolution;
+  const int H = resolution;
+  const int D = resolution;
 
   auto &voxels = chunk.voxelData;
   auto &registry = world.registry;
 
-  std::vector<VoxelVertex> vertices;
-  std::vector<uint32_t> indices;
-
   glm::vec3 chunkWorldPos = glm::vec3(chunk.worldPosition);
 
   for (int axis = 0; axis < 3; axis++)
@@ -189,14 +239,14 @@ void MeshingSystem::CreateMesh(Texture voxelTextures, Renderer &renderer, Entity
           x[u] = y[u] = i;
           x[v] = y[v] = j;
 
-          bool a = IsSolid(voxels, registry, x[0], x[1], x[2], step);
-          bool b = IsSolid(voxels, registry, y[0], y[1], y[2], step);
+          bool a = IsSolid(voxels, registry, x[0], x[1], x[2], resolution);
+          bool b = IsSolid(voxels, registry, y[0], y[1], y[2], resolution);
 
           if (a == b)
             mask[n++] = 0;
           else
           {
-            int idx = a ? voxels[Index3D(x[0] * step, x[1] * step, x[2] * step)].type : voxels[Index3D(y[0] * step, y[1] * step, y[2] * step)].type;
+            int idx = a ? voxels[Index3D(x[0], x[1], x[2], resolution)].type : voxels[Index3D(y[0], y[1], y[2], resolution)].type;
 
             mask[n++] = a ? (idx + 1) : -(idx + 1);
           }
@@ -268,12 +318,21 @@ void MeshingSystem::CreateMesh(Texture voxelTextures, Renderer &renderer, Entity
       }
     }
   }
+}
+
+void MeshingSystem::UploadMesh(Texture voxelTextures, Renderer &renderer, Entity chunkEntity, const std::vector<VoxelVertex> &vertices, const std::vector<uint32_t> &indices)
+{
+  PROFILE_ZONE("MeshingSystem::UploadMesh");
+  auto &chunk = gCoordinator->GetComponent<ChunkComponent>(chunkEntity);
+
+  // component changes are deferred to the next sync point, this system is still iterating its entities
+  CommandBuffer &commands = gCoordinator->GetCommandBuffer();
 
   if (gCoordinator->HasComponent<VoxelMeshComponent>(chunkEntity))
   {
     VoxelMeshComponent mesh = gCoordinator->GetComponent<VoxelMeshComponent>(chunkEntity);
     mesh.mesh->Cleanup();
-    gCoordinator->RemoveComponent<VoxelMeshComponent>(chunkEntity);
+    commands.RemoveComponent<VoxelMeshComponent>(chunkEntity);
   }
 
   if (vertices.size() > 0 && indices.size() > 0)
@@ -283,9 +342,11 @@ void MeshingSystem::CreateMesh(Texture voxelTextures, Renderer &renderer, Entity
     chunkTransform.scale = {1.0f, 1.0f, 1.0f};
     renderer.storageBufferAccess[chunk.gpuIndex].model = chunkTransform.GetMatrix();
 
-    gCoordinator->AddComponent(chunkEntity, chunkTransform);
+    if (!gCoordinator->HasComponent<TransformComponent>(chunkEntity))
+      commands.AddComponent(chunkEntity, chunkTransform);
+
     auto mesh = std::make_shared<VoxelMesh>(renderer);
     mesh->Init(voxelTextures, vertices, indices, chunk.gpuIndex);
-    gCoordinator->AddComponent(chunkEntity, VoxelMeshComponent{mesh});
+    commands.AddComponent(chunkEntity, VoxelMeshComponent{mesh});
   }
 }
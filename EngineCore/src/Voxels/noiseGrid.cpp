@@ -0,0 +1,523 @@
+#include "noiseGrid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NOISE_GRID_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#define NOISE_GRID_SSE
+#endif
+
+// The lane kernels below follow FastNoiseLite's 2D Perlin, OpenSimplex2 and FBm code operation for
+// operation (same constants, same evaluation order, same floor quirk) so every lane rounds exactly
+// like the scalar version. Keep them in sync when FastNoiseLite.h is updated.
+
+namespace
+{
+  // FastNoiseLite::Lookup<float>::Gradients2D, which is private
+  alignas(32) const float Gradients2D[256] = {
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.38268343236509f, 0.923879532511287f, 0.923879532511287f, 0.38268343236509f, 0.923879532511287f, -0.38268343236509f, 0.38268343236509f, -0.923879532511287f,
+    -0.38268343236509f, -0.923879532511287f, -0.923879532511287f, -0.38268343236509f, -0.923879532511287f, 0.38268343236509f, -0.38268343236509f, 0.923879532511287f,
+  };
+
+  const int PrimeX = 501125321;
+  const int PrimeY = 1136930381;
+
+  struct ScalarLanes
+  {
+    using F = float;
+    using I = int32_t;
+    using M = bool;
+    static constexpr int Width = 1;
+
+    static F Set(float v) { return v; }
+    static I SetI(int32_t v) { return v; }
+    static void Store(float *p, F v) { *p = v; }
+    static F Iota() { return 0.0f; }
+
+    static F Add(F a, F b) { return a + b; }
+    static F Sub(F a, F b) { return a - b; }
+    static F Mul(F a, F b) { return a * b; }
+    static F Min(F a, F b) { return a < b ? a : b; }
+    static M Greater(F a, F b) { return a > b; }
+    static M LessEqual(F a, F b) { return a <= b; }
+    static F Select(M m, F a, F b) { return m ? a : b; }
+    static I SelectI(M m, I a, I b) { return m ? a : b; }
+
+    static I Floor(F f) { return f >= 0 ? (int)f : (int)f - 1; }
+    static F ToFloat(I i) { return (float)i; }
+
+    // integer math wraps like FastNoiseLite relies on
+    static I AddI(I a, I b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+    static I MulI(I a, I b) { return (int32_t)((uint32_t)a * (uint32_t)b); }
+    static I XorI(I a, I b) { return a ^ b; }
+    static I AndI(I a, I b) { return a & b; }
+    static I ShiftRight15(I a) { return a >> 15; }
+
+    static F Gather(const float *table, I index) { return table[index]; }
+  };
+
+#if defined(NOISE_GRID_AVX2)
+  struct Avx2Lanes
+  {
+    using F = __m256;
+    using I = __m256i;
+    using M = __m256;
+    static constexpr int Width = 8;
+
+    static F Set(float v) { return _mm256_set1_ps(v); }
+    static I SetI(int32_t v) { return _mm256_set1_epi32(v); }
+    static void Store(float *p, F v) { _mm256_storeu_ps(p, v); }
+    static F Iota() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+
+    static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F Min(F a, F b) { return _mm256_min_ps(a, b); }
+    static M Greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static M LessEqual(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static F Select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+    static I SelectI(M m, I a, I b) { return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), m)); }
+
+    static I Floor(F f)
+    {
+      M negative = _mm256_cmp_ps(f, _mm256_setzero_ps(), _CMP_LT_OQ);
+      return _mm256_add_epi32(_mm256_cvttps_epi32(f), _mm256_castps_si256(negative));
+    }
+    static F ToFloat(I i) { return _mm256_cvtepi32_ps(i); }
+
+    static I AddI(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I MulI(I a, I b) { return _mm256_mullo_epi32(a, b); }
+    static I XorI(I a, I b) { return _mm256_xor_si256(a, b); }
+    static I AndI(I a, I b) { return _mm256_and_si256(a, b); }
+    static I ShiftRight15(I a) { return _mm256_srai_epi32(a, 15); }
+
+    static F Gather(const float *table, I index) { return _mm256_i32gather_ps(table, index, 4); }
+  };
+  using BatchLanes = Avx2Lanes;
+  const char *batchPath = "avx2";
+#elif defined(NOISE_GRID_SSE)
+  struct SseLanes
+  {
+    using F = __m128;
+    using I = __m128i;
+    using M = __m128;
+    static constexpr int Width = 4;
+
+    static F Set(float v) { return _mm_set1_ps(v); }
+    static I SetI(int32_t v) { return _mm_set1_epi32(v); }
+    static void Store(float *p, F v) { _mm_storeu_ps(p, v); }
+    static F Iota() { return _mm_setr_ps(0, 1, 2, 3); }
+
+    static F Add(F a, F b) { return _mm_add_ps(a, b); }
+    static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F Min(F a, F b) { return _mm_min_ps(a, b); }
+    static M Greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+    static M LessEqual(F a, F b) { return _mm_cmple_ps(a, b); }
+    static F Select(M m, F a, F b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static I SelectI(M m, I a, I b)
+    {
+      I mask = _mm_castps_si128(m);
+      return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    static I Floor(F f)
+    {
+      M negative = _mm_cmplt_ps(f, _mm_setzero_ps());
+      return _mm_add_epi32(_mm_cvttps_epi32(f), _mm_castps_si128(negative));
+    }
+    static F ToFloat(I i) { return _mm_cvtepi32_ps(i); }
+
+    static I AddI(I a, I b) { return _mm_add_epi32(a, b); }
+    static I MulI(I a, I b)
+    {
+#if defined(__SSE4_1__)
+      return _mm_mullo_epi32(a, b);
+#else
+      // SSE2 only has 32x32->64 multiplies on even lanes, do even and odd lanes separately
+      I even = _mm_mul_epu32(a, b);
+      I odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+      return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+    }
+    static I XorI(I a, I b) { return _mm_xor_si128(a, b); }
+    static I AndI(I a, I b) { return _mm_and_si128(a, b); }
+    static I ShiftRight15(I a) { return _mm_srai_epi32(a, 15); }
+
+    static F Gather(const float *table, I index)
+    {
+      alignas(16) int32_t i[4];
+      _mm_store_si128(reinterpret_cast<__m128i *>(i), index);
+      return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+    }
+  };
+  using BatchLanes = SseLanes;
+  const char *batchPath = "sse";
+#else
+  using BatchLanes = ScalarLanes;
+  const char *batchPath = "scalar";
+#endif
+
+  template <typename L>
+  typename L::F Lerp(typename L::F a, typename L::F b, typename L::F t)
+  {
+    return L::Add(a, L::Mul(t, L::Sub(b, a)));
+  }
+
+  template <typename L>
+  typename L::F InterpQuintic(typename L::F t)
+  {
+    // t * t * t * (t * (t * 6 - 15) + 10)
+    auto t3 = L::Mul(L::Mul(t, t), t);
+    auto inner = L::Add(L::Mul(t, L::Sub(L::Mul(t, L::Set(6)), L::Set(15))), L::Set(10));
+    return L::Mul(t3, inner);
+  }
+
+  template <typename L>
+  typename L::F GradCoord(typename L::I seed, typename L::I xPrimed, typename L::I yPrimed, typename L::F xd, typename L::F yd)
+  {
+    auto hash = L::MulI(L::XorI(L::XorI(seed, xPrimed), yPrimed), L::SetI(0x27d4eb2d));
+    hash = L::XorI(hash, L::ShiftRight15(hash));
+    hash = L::AndI(hash, L::SetI(127 << 1));
+
+    // hash is even, so hash | 1 is the next entry
+    auto xg = L::Gather(Gradients2D, hash);
+    auto yg = L::Gather(Gradients2D + 1, hash);
+
+    return L::Add(L::Mul(xd, xg), L::Mul(yd, yg));
+  }
+
+  template <typename L>
+  typename L::F SinglePerlin(int seed, typename L::F x, typename L::F y)
+  {
+    auto x0 = L::Floor(x);
+    auto y0 = L::Floor(y);
+
+    auto xd0 = L::Sub(x, L::ToFloat(x0));
+    auto yd0 = L::Sub(y, L::ToFloat(y0));
+    auto xd1 = L::Sub(xd0, L::Set(1));
+    auto yd1 = L::Sub(yd0, L::Set(1));
+
+    auto xs = InterpQuintic<L>(xd0);
+    auto ys = InterpQuintic<L>(yd0);
+
+    x0 = L::MulI(x0, L::SetI(PrimeX));
+    y0 = L::MulI(y0, L::SetI(PrimeY));
+    auto x1 = L::AddI(x0, L::SetI(PrimeX));
+    auto y1 = L::AddI(y0, L::SetI(PrimeY));
+
+    auto s = L::SetI(seed);
+    auto xf0 = Lerp<L>(GradCoord<L>(s, x0, y0, xd0, yd0), GradCoord<L>(s, x1, y0, xd1, yd0), xs);
+    auto xf1 = Lerp<L>(GradCoord<L>(s, x0, y1, xd0, yd1), GradCoord<L>(s, x1, y1, xd1, yd1), xs);
+
+    return L::Mul(Lerp<L>(xf0, xf1, ys), L::Set(1.4247691104677813f));
+  }
+
+  template <typename L>
+  typename L::F SingleSimplex(int seed, typename L::F x, typename L::F y)
+  {
+    const float SQRT3 = 1.7320508075688772935274463415059f;
+    const float G2 = (3 - SQRT3) / 6;
+
+    auto i = L::Floor(x);
+    auto j = L::Floor(y);
+    auto xi = L::Sub(x, L::ToFloat(i));
+    auto yi = L::Sub(y, L::ToFloat(j));
+
+    auto t = L::Mul(L::Add(xi, yi), L::Set(G2));
+    auto x0 = L::Sub(xi, t);
+    auto y0 = L::Sub(yi, t);
+
+    i = L::MulI(i, L::SetI(PrimeX));
+    j = L::MulI(j, L::SetI(PrimeY));
+
+    auto s = L::SetI(seed);
+    auto zero = L::Set(0);
+
+    auto a = L::Sub(L::Sub(L::Set(0.5f), L::Mul(x0, x0)), L::Mul(y0, y0));
+    auto aa = L::Mul(a, a);
+    auto n0 = L::Mul(L::Mul(aa, aa), GradCoord<L>(s, i, j, x0, y0));
+    n0 = L::Select(L::LessEqual(a, zero), zero, n0);
+
+    const float cScale = (float)(2 * (1 - 2 * G2) * (1 / G2 - 2));
+    const float cOffset = (float)(-2 * (1 - 2 * G2) * (1 - 2 * G2));
+    auto c = L::Add(L::Mul(L::Set(cScale), t), L::Add(L::Set(cOffset), a));
+    auto x2 = L::Add(x0, L::Set(2 * (float)G2 - 1));
+    auto y2 = L::Add(y0, L::Set(2 * (float)G2 - 1));
+    auto cc = L::Mul(c, c);
+    auto n2 = L::Mul(L::Mul(cc, cc), GradCoord<L>(s, L::AddI(i, L::SetI(PrimeX)), L::AddI(j, L::SetI(PrimeY)), x2, y2));
+    n2 = L::Select(L::LessEqual(c, zero), zero, n2);
+
+    // the middle corner depends on which triangle of the cell the point is in
+    auto upper = L::Greater(y0, x0);
+    auto x1 = L::Select(upper, L::Add(x0, L::Set((float)G2)), L::Add(x0, L::Set((float)G2 - 1)));
+    auto y1 = L::Select(upper, L::Add(y0, L::Set((float)G2 - 1)), L::Add(y0, L::Set((float)G2)));
+    auto i1 = L::SelectI(upper, i, L::AddI(i, L::SetI(PrimeX)));
+    auto j1 = L::SelectI(upper, L::AddI(j, L::SetI(PrimeY)), j);
+
+    auto b = L::Sub(L::Sub(L::Set(0.5f), L::Mul(x1, x1)), L::Mul(y1, y1));
+    auto bb = L::Mul(b, b);
+    auto n1 = L::Mul(L::Mul(bb, bb), GradCoord<L>(s, i1, j1, x1, y1));
+    n1 = L::Select(L::LessEqual(b, zero), zero, n1);
+
+    return L::Mul(L::Add(L::Add(n0, n1), n2), L::Set(99.83685446303647f));
+  }
+
+  template <typename L>
+  typename L::F GenNoiseSingle(const NoiseSettings &settings, int seed, typename L::F x, typename L::F y)
+  {
+    if (settings.noiseType == FastNoiseLite::NoiseType_Perlin)
+      return SinglePerlin<L>(seed, x, y);
+    return SingleSimplex<L>(seed, x, y);
+  }
+
+  template <typename L>
+  typename L::F Sample(const NoiseSettings &settings, float fractalBounding, typename L::F x, typename L::F y)
+  {
+    x = L::Mul(x, L::Set(settings.frequency));
+    y = L::Mul(y, L::Set(settings.frequency));
+
+    if (settings.noiseType == FastNoiseLite::NoiseType_OpenSimplex2)
+    {
+      const float SQRT3 = (float)1.7320508075688772935274463415059;
+      const float F2 = 0.5f * (SQRT3 - 1);
+      auto t = L::Mul(L::Add(x, y), L::Set(F2));
+      x = L::Add(x, t);
+      y = L::Add(y, t);
+    }
+
+    if (settings.fractalType != FastNoiseLite::FractalType_FBm)
+      return GenNoiseSingle<L>(settings, settings.seed, x, y);
+
+    int seed = settings.seed;
+    auto sum = L::Set(0);
+    auto amp = L::Set(fractalBounding);
+
+    for (int i = 0; i < settings.octaves; i++)
+    {
+      auto noise = GenNoiseSingle<L>(settings, seed++, x, y);
+      sum = L::Add(sum, L::Mul(noise, amp));
+
+      auto weight = L::Mul(L::Min(L::Add(noise, L::Set(1)), L::Set(2)), L::Set(0.5f));
+      amp = L::Mul(amp, Lerp<L>(L::Set(1.0f), weight, L::Set(settings.weightedStrength)));
+
+      x = L::Mul(x, L::Set(settings.lacunarity));
+      y = L::Mul(y, L::Set(settings.lacunarity));
+      amp = L::Mul(amp, L::Set(settings.gain));
+    }
+
+    return sum;
+  }
+}
+
+NoiseLayer::NoiseLayer(const NoiseSettings &settings)
+{
+  Configure(settings);
+}
+
+void NoiseLayer::Configure(const NoiseSettings &settings)
+{
+  this->settings = settings;
+
+  noise.SetSeed(settings.seed);
+  noise.SetNoiseType(settings.noiseType);
+  noise.SetFrequency(settings.frequency);
+  noise.SetFractalType(settings.fractalType);
+  noise.SetFractalOctaves(settings.octaves);
+  noise.SetFractalLacunarity(settings.lacunarity);
+  noise.SetFractalGain(settings.gain);
+  noise.SetFractalWeightedStrength(settings.weightedStrength);
+
+  // same as FastNoiseLite::CalculateFractalBounding
+  float gain = settings.gain < 0 ? -settings.gain : settings.gain;
+  float amp = gain;
+  float ampFractal = 1.0f;
+  for (int i = 1; i < settings.octaves; i++)
+  {
+    ampFractal += amp;
+    amp *= gain;
+  }
+  fractalBounding = 1 / ampFractal;
+}
+
+bool NoiseLayer::IsBatched() const
+{
+  bool noiseSupported = settings.noiseType == FastNoiseLite::NoiseType_Perlin || settings.noiseType == FastNoiseLite::NoiseType_OpenSimplex2;
+  bool fractalSupported = settings.fractalType == FastNoiseLite::FractalType_None || settings.fractalType == FastNoiseLite::FractalType_FBm;
+  return noiseSupported && fractalSupported;
+}
+
+void NoiseLayer::FillGrid(float *out, int countX, int countY, float startX, float startY, float step) const
+{
+  if (!IsBatched())
+  {
+    FillGridScalar(out, countX, countY, startX, startY, step);
+    return;
+  }
+
+  using L = BatchLanes;
+  const auto laneOffsets = L::Iota();
+
+  for (int j = 0; j < countY; j++)
+  {
+    float y = startY + (float)j * step;
+    float *row = out + (size_t)countX * j;
+
+    int i = 0;
+    for (; i + L::Width <= countX; i += L::Width)
+    {
+      auto x = L::Add(L::Set(startX), L::Mul(L::Add(L::Set((float)i), laneOffsets), L::Set(step)));
+      L::Store(row + i, Sample<L>(settings, fractalBounding, x, L::Set(y)));
+    }
+
+    // leftover columns go through the scalar reference
+    for (; i < countX; i++)
+      row[i] = noise.GetNoise(startX + (float)i * step, y);
+  }
+}
+
+void NoiseLayer::FillGridScalar(float *out, int countX, int countY, float startX, float startY, float step) const
+{
+  for (int j = 0; j < countY; j++)
+  {
+    float y = startY + (float)j * step;
+    for (int i = 0; i < countX; i++)
+      out[i + (size_t)countX * j] = noise.GetNoise(startX + (float)i * step, y);
+  }
+}
+
+static int FloorDiv(int a, int b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+void NoiseLayer::FillGridInterpolated(float *out, int countX, int countY, int startX, int startY, int stride, int step) const
+{
+  if (stride <= step)
+  {
+    FillGrid(out, countX, countY, (float)startX, (float)startY, (float)step);
+    return;
+  }
+
+  // lattice cells covering the grid, one extra point past the last cell on each axis
+  const int latticeX = FloorDiv(startX, stride);
+  const int latticeY = FloorDiv(startY, stride);
+  const int latticeCountX = FloorDiv(startX + (countX - 1) * step, stride) - latticeX + 2;
+  const int latticeCountY = FloorDiv(startY + (countY - 1) * step, stride) - latticeY + 2;
+
+  std::vector<float> lattice((size_t)latticeCountX * latticeCountY);
+  FillGrid(lattice.data(), latticeCountX, latticeCountY, (float)(latticeX * stride), (float)(latticeY * stride), (float)stride);
+
+  std::vector<int> cellX(countX);
+  std::vector<float> weightX(countX);
+  for (int i = 0; i < countX; i++)
+  {
+    int x = startX + i * step;
+    cellX[i] = FloorDiv(x, stride) - latticeX;
+    weightX[i] = (float)(x - (cellX[i] + latticeX) * stride) / stride;
+  }
+
+  for (int j = 0; j < countY; j++)
+  {
+    int y = startY + j * step;
+    int cellY = FloorDiv(y, stride) - latticeY;
+    float weightY = (float)(y - (cellY + latticeY) * stride) / stride;
+
+    const float *row0 = lattice.data() + (size_t)latticeCountX * cellY;
+    const float *row1 = row0 + latticeCountX;
+    float *row = out + (size_t)countX * j;
+
+    for (int i = 0; i < countX; i++)
+    {
+      int c = cellX[i];
+      float t = weightX[i];
+      float v0 = row0[c] + t * (row0[c + 1] - row0[c]);
+      float v1 = row1[c] + t * (row1[c + 1] - row1[c]);
+      row[i] = v0 + weightY * (v1 - v0);
+    }
+  }
+}
+
+void NoiseLayer::FillGridSampled(float *out, int countX, int countY, int startX, int startY, int step) const
+{
+  FillGridInterpolated(out, countX, countY, startX, startY, stride, step);
+}
+
+float NoiseLayer::MeasureInterpolationError(int stride) const
+{
+  if (stride <= 1)
+    return 0.0f;
+
+  // a few odd sized grids away from the origin and on both sides of it
+  const int size = 61;
+  const int origins[][2] = {{0, 0}, {-1000, 517}, {4093, -2711}, {-7919, -3253}, {12007, 9001}};
+
+  std::vector<float> exact(size * size), interpolated(size * size);
+  float worst = 0.0f;
+  for (auto const &origin : origins)
+  {
+    FillGrid(exact.data(), size, size, (float)origin[0], (float)origin[1]);
+    FillGridInterpolated(interpolated.data(), size, size, origin[0], origin[1], stride);
+    for (size_t i = 0; i < exact.size(); i++)
+      worst = std::max(worst, std::fabs(exact[i] - interpolated[i]));
+  }
+
+  return worst;
+}
+
+void NoiseLayer::SetSampling(int maxStride, float maxError)
+{
+  this->maxError = maxError;
+  stride = 1;
+
+  for (int candidate = maxStride; candidate > 1; candidate /= 2)
+  {
+    if (MeasureInterpolationError(candidate) <= maxError)
+    {
+      stride = candidate;
+      return;
+    }
+  }
+}
+
+const char *NoiseBatchPath()
+{
+  return batchPath;
+}
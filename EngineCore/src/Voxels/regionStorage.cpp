@@ -0,0 +1,313 @@
+#include "regionStorage.hpp"
+#include "voxelCodec.hpp"
+
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &path)
+{
+#ifdef _WIN32
+  file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    file = nullptr;
+    return;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    return;
+
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+    return;
+
+  data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (data)
+    size = (size_t)fileSize.QuadPart;
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+  {
+    void *mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped != MAP_FAILED)
+    {
+      data = static_cast<const uint8_t *>(mapped);
+      size = (size_t)info.st_size;
+    }
+  }
+
+  close(fd); // the mapping keeps the file alive
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+  if (data)
+    UnmapViewOfFile(data);
+  if (mapping)
+    CloseHandle(mapping);
+  if (file)
+    CloseHandle(file);
+#else
+  if (data)
+    munmap(const_cast<uint8_t *>(data), size);
+#endif
+}
+
+RegionStorage::~RegionStorage()
+{
+  Close();
+}
+
+bool RegionStorage::Open(const std::string &directory)
+{
+  Close();
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error)
+  {
+    std::cerr << "Failed to create region directory! Directory: " << directory << " (" << error.message() << ")" << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  this->directory = directory;
+  open = true;
+  return true;
+}
+
+void RegionStorage::Close()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  regions.clear();
+  open = false;
+}
+
+// region files can pass 2 GiB since rewrites only append, plain fseek and ftell take a long which is
+// 32 bits on Windows
+static bool SeekFile(std::FILE *file, uint64_t offset)
+{
+#ifdef _WIN32
+  return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+  return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static uint64_t FileEnd(std::FILE *file)
+{
+#ifdef _WIN32
+  _fseeki64(file, 0, SEEK_END);
+  return (uint64_t)_ftelli64(file);
+#else
+  fseeko(file, 0, SEEK_END);
+  return (uint64_t)ftello(file);
+#endif
+}
+
+static int FloorDiv(int value, int divisor)
+{
+  int quotient = value / divisor;
+  if ((value % divisor != 0) && ((value < 0) != (divisor < 0)))
+    quotient--;
+  return quotient;
+}
+
+RegionStorage::Region *RegionStorage::GetRegionLocked(int x, int y, int z, int &index)
+{
+  const RegionKey key{FloorDiv(x, RegionSize), FloorDiv(y, RegionSize), FloorDiv(z, RegionSize)};
+  index = (x - key.x * RegionSize) + RegionSize * ((z - key.z * RegionSize) + RegionSize * (y - key.y * RegionSize));
+
+  auto it = regions.find(key);
+  if (it != regions.end())
+  {
+    it->second->lastUse = ++useCounter;
+    return it->second.get();
+  }
+
+  // Everything a region holds can be read back from its file, the table is flushed with every write.
+  // Readers keep the mapping they took alive.
+  if (regions.size() >= MaxCachedRegions)
+  {
+    auto oldest = regions.begin();
+    for (auto candidate = regions.begin(); candidate != regions.end(); ++candidate)
+    {
+      if (candidate->second->lastUse < oldest->second->lastUse)
+        oldest = candidate;
+    }
+    regions.erase(oldest);
+  }
+
+  // missing files are remembered as empty regions while cached, so reads do not keep checking the disk
+  auto region = std::make_unique<Region>();
+  region->path = (std::filesystem::path(directory) / ("r." + std::to_string(key.x) + "." + std::to_string(key.y) + "." + std::to_string(key.z) + ".region")).string();
+  region->entries.resize(ChunksPerRegion);
+
+  if (std::FILE *file = std::fopen(region->path.c_str(), "rb"))
+  {
+    Header header{};
+    bool valid = std::fread(&header, sizeof(Header), 1, file) == 1 &&
+                 header.magic == Magic && header.version == Version &&
+                 std::fread(region->entries.data(), sizeof(Entry), ChunksPerRegion, file) == ChunksPerRegion;
+
+    region->fileSize = FileEnd(file);
+    std::fclose(file);
+
+    if (!valid)
+    {
+      std::cerr << "Invalid region file, it will not be read or written! File: " << region->path << std::endl;
+      region->entries.assign(ChunksPerRegion, Entry{});
+      region->valid = false;
+    }
+  }
+
+  region->lastUse = ++useCounter;
+  Region *result = region.get();
+  regions.emplace(key, std::move(region));
+  return result;
+}
+
+bool RegionStorage::Read(int x, int y, int z, int maxLod, std::vector<Voxel> &voxels, int &lod)
+{
+  std::shared_ptr<MappedFile> mapped;
+  Entry entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!open)
+      return false;
+
+    int index;
+    Region *region = GetRegionLocked(x, y, z, index);
+    entry = region->entries[index];
+    if (entry.offset == 0 || entry.lod > maxLod)
+      return false;
+
+    // written data is flushed before the table points at it, so a fresh mapping always covers it
+    if (!region->mapped || region->mapped->Size() < entry.offset + entry.length)
+      region->mapped = std::make_shared<MappedFile>(region->path);
+
+    mapped = region->mapped;
+    if (mapped->Size() < entry.offset + entry.length)
+      return false;
+
+    bytesRead += entry.length;
+  }
+
+  // decoding happens outside the lock, the mapping stays alive while this thread holds it
+  if (!DecodeVoxels(mapped->Data() + entry.offset, entry.length, voxels))
+  {
+    std::cerr << "Corrupt chunk in region storage! Chunk: " << x << ", " << y << ", " << z << std::endl;
+    return false;
+  }
+
+  lod = entry.lod;
+  return true;
+}
+
+bool RegionStorage::Contains(int x, int y, int z, int lod)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!open)
+    return false;
+
+  int index;
+  const Entry &entry = GetRegionLocked(x, y, z, index)->entries[index];
+  return entry.offset != 0 && entry.lod <= lod;
+}
+
+bool RegionStorage::Write(int x, int y, int z, int lod, const Voxel *voxels, size_t count)
+{
+  std::vector<uint8_t> data;
+  EncodeVoxels(voxels, count, data);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!open)
+    return false;
+
+  int index;
+  Region *region = GetRegionLocked(x, y, z, index);
+  if (!region->valid)
+    return false;
+
+  Entry &entry = region->entries[index];
+  if (entry.offset != 0 && entry.lod < lod)
+    return true;
+
+  if (!region->file)
+  {
+    if (region->fileSize == 0)
+    {
+      // new region, the table starts out empty
+      region->file = std::fopen(region->path.c_str(), "w+b");
+      if (region->file)
+      {
+        Header header{Magic, Version};
+        std::fwrite(&header, sizeof(Header), 1, region->file);
+        std::fwrite(region->entries.data(), sizeof(Entry), ChunksPerRegion, region->file);
+        region->fileSize = DataStart;
+      }
+    }
+    else
+      region->file = std::fopen(region->path.c_str(), "r+b");
+
+    if (!region->file)
+    {
+      std::cerr << "Failed to open region file for writing! File: " << region->path << std::endl;
+      return false;
+    }
+  }
+
+  Entry updated;
+  updated.offset = region->fileSize;
+  updated.length = (uint32_t)data.size();
+  updated.lod = (uint8_t)lod;
+
+  // data first, then the table entry, so the entry never points at data that is not there
+  bool written = SeekFile(region->file, updated.offset) &&
+                 std::fwrite(data.data(), 1, data.size(), region->file) == data.size() &&
+                 std::fflush(region->file) == 0 &&
+                 SeekFile(region->file, sizeof(Header) + sizeof(Entry) * index) &&
+                 std::fwrite(&updated, sizeof(Entry), 1, region->file) == 1 &&
+                 std::fflush(region->file) == 0;
+
+  if (!written)
+  {
+    std::cerr << "Failed to write chunk to region file! File: " << region->path << std::endl;
+    return false;
+  }
+
+  entry = updated;
+  region->fileSize += data.size();
+  bytesWritten += data.size();
+  return true;
+}
+
+uint64_t RegionStorage::BytesRead()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return bytesRead;
+}
+
+uint64_t RegionStorage::BytesWritten()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return bytesWritten;
+}
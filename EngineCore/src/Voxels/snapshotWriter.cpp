@@ -0,0 +1,137 @@
+#include "snapshotWriter.hpp"
+
+SnapshotWriter::~SnapshotWriter()
+{
+  Wait();
+}
+
+bool SnapshotWriter::Start(RegionStorage &storage, std::vector<Chunk> chunks)
+{
+  if (inProgress)
+    return false;
+  Wait(); // joins the thread of the last save, which is already done
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    lookup.clear();
+    entries.reserve(chunks.size());
+    for (const Chunk &chunk : chunks)
+    {
+      lookup[chunk.coord] = entries.size();
+      entries.push_back({chunk, {}, false, false});
+    }
+  }
+
+  inProgress = true;
+  thread = std::thread(&SnapshotWriter::Run, this, &storage);
+  return true;
+}
+
+void SnapshotWriter::Wait()
+{
+  if (thread.joinable())
+    thread.join();
+}
+
+void SnapshotWriter::Run(RegionStorage *storage)
+{
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    std::vector<Voxel> copy;
+    Chunk chunk;
+    bool live;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      Entry &entry = entries[i];
+      chunk = entry.chunk;
+      live = !entry.copied;
+      if (live)
+        writing = i;
+      else
+        copy = std::move(entry.copy);
+    }
+
+    // the live data cannot change under the write, Preserve and Release wait for it to finish
+    if (live)
+      storage->Write(chunk.coord.x, chunk.coord.y, chunk.coord.z, chunk.lod, chunk.voxels, chunk.count);
+    else
+      storage->Write(chunk.coord.x, chunk.coord.y, chunk.coord.z, chunk.lod, copy);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      entries[i].written = true;
+      writing = None;
+      written++;
+    }
+    chunkWritten.notify_all();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.clear();
+  lookup.clear();
+  inProgress = false;
+}
+
+SnapshotWriter::Entry *SnapshotWriter::PendingLocked(const glm::ivec3 &coord, std::unique_lock<std::mutex> &lock)
+{
+  auto it = lookup.find(coord);
+  if (it == lookup.end())
+    return nullptr;
+
+  const size_t index = it->second;
+  chunkWritten.wait(lock, [&]
+                    { return writing != index; });
+
+  // the thread clears the entries once it is done, so check again after waiting
+  if (entries.empty() || entries[index].written)
+    return nullptr;
+  return &entries[index];
+}
+
+void SnapshotWriter::Preserve(const glm::ivec3 &coord, const std::vector<Voxel> &voxels)
+{
+  if (!inProgress)
+    return;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  Entry *entry = PendingLocked(coord, lock);
+  if (!entry || entry->copied)
+    return;
+
+  entry->copy = voxels;
+  entry->copied = true;
+  copied++;
+}
+
+bool SnapshotWriter::Release(const glm::ivec3 &coord, std::vector<Voxel> &voxels)
+{
+  if (!inProgress)
+    return false;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  Entry *entry = PendingLocked(coord, lock);
+  if (!entry)
+    return false;
+
+  if (!entry->copied)
+  {
+    entry->copy = std::move(voxels);
+    voxels.clear();
+    entry->copied = true;
+    copied++;
+  }
+  return true;
+}
+
+uint64_t SnapshotWriter::ChunksWritten()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return written;
+}
+
+uint64_t SnapshotWriter::ChunksCopied()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return copied;
+}
@@ -0,0 +1,292 @@
+#include "voxelCodec.hpp"
+#include <algorithm>
+#include <cstring>
+
+void WriteVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
+
+bool ReadVarint(const uint8_t *&data, const uint8_t *end, uint64_t &value)
+{
+  value = 0;
+  for (int shift = 0; shift < 64 && data < end; shift += 7)
+  {
+    uint8_t byte = *data++;
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// the first byte of an encoded chunk
+enum CodecFlags : uint8_t
+{
+  CodecLZ = 1, // the run stream is LZ compressed
+};
+
+static const size_t MaxVoxels = 1 << 24;
+
+static int PaletteBits(size_t paletteSize)
+{
+  int bits = 0;
+  while (((size_t)1 << bits) < paletteSize)
+    bits++;
+  return bits;
+}
+
+// Palette, then every run as one varint holding its length above the palette index.
+static void EncodeRuns(const Voxel *voxels, size_t count, std::vector<uint8_t> &out)
+{
+  std::vector<uint32_t> palette;
+  std::vector<std::pair<uint32_t, size_t>> runs;
+  for (size_t i = 0; i < count;)
+  {
+    const uint32_t type = voxels[i].type;
+    size_t run = 1;
+    while (i + run < count && voxels[i + run].type == type)
+      run++;
+
+    // chunks hold a handful of block types, a linear search beats hashing
+    uint32_t index = (uint32_t)(std::find(palette.begin(), palette.end(), type) - palette.begin());
+    if (index == palette.size())
+      palette.push_back(type);
+
+    runs.push_back({index, run});
+    i += run;
+  }
+
+  WriteVarint(out, count);
+  WriteVarint(out, palette.size());
+  for (uint32_t type : palette)
+    WriteVarint(out, type);
+
+  const int bits = PaletteBits(palette.size());
+  for (const auto &[index, run] : runs)
+    WriteVarint(out, ((uint64_t)(run - 1) << bits) | index);
+}
+
+static bool DecodeRuns(const uint8_t *data, const uint8_t *end, std::vector<Voxel> &voxels)
+{
+  uint64_t count, paletteSize;
+  if (!ReadVarint(data, end, count) || count > MaxVoxels || !ReadVarint(data, end, paletteSize) || paletteSize > count)
+    return false;
+
+  std::vector<uint32_t> palette(paletteSize);
+  for (uint32_t &type : palette)
+  {
+    uint64_t value;
+    if (!ReadVarint(data, end, value))
+      return false;
+    type = (uint32_t)value;
+  }
+
+  const int bits = PaletteBits(palette.size());
+  const uint64_t mask = ((uint64_t)1 << bits) - 1;
+
+  voxels.resize(count);
+  Voxel *out = voxels.data();
+  size_t i = 0;
+  while (i < count)
+  {
+    uint64_t value;
+    if (!ReadVarint(data, end, value))
+      return false;
+
+    const uint64_t index = value & mask;
+    const uint64_t run = (value >> bits) + 1;
+    if (index >= palette.size() || run > count - i)
+      return false;
+
+    std::fill(out + i, out + i + run, Voxel{palette[index]});
+    i += run;
+  }
+
+  return data == end;
+}
+
+static uint32_t Read32(const uint8_t *p)
+{
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static void WriteLength(std::vector<uint8_t> &out, size_t length)
+{
+  while (length >= 255)
+  {
+    out.push_back(255);
+    length -= 255;
+  }
+  out.push_back((uint8_t)length);
+}
+
+// LZ4 style sequences: a token with the literal and match lengths, the literals, then a two byte
+// offset back to the match. The last sequence is literals only.
+static void CompressLZ(const uint8_t *in, size_t size, std::vector<uint8_t> &out)
+{
+  static const int HashBits = 12;
+  static const size_t MinMatch = 4;
+  int32_t table[1 << HashBits];
+  std::fill(std::begin(table), std::end(table), -1);
+
+  auto emit = [&](size_t literalStart, size_t literalLength, size_t offset, size_t matchLength)
+  {
+    uint8_t token = (uint8_t)(std::min<size_t>(literalLength, 15) << 4);
+    if (matchLength > 0)
+      token |= (uint8_t)std::min<size_t>(matchLength - MinMatch, 15);
+    out.push_back(token);
+
+    if (literalLength >= 15)
+      WriteLength(out, literalLength - 15);
+    out.insert(out.end(), in + literalStart, in + literalStart + literalLength);
+
+    if (matchLength == 0)
+      return;
+    out.push_back((uint8_t)offset);
+    out.push_back((uint8_t)(offset >> 8));
+    if (matchLength - MinMatch >= 15)
+      WriteLength(out, matchLength - MinMatch - 15);
+  };
+
+  size_t anchor = 0;
+  size_t i = 0;
+  while (i + MinMatch <= size)
+  {
+    const uint32_t sequence = Read32(in + i);
+    const uint32_t hash = (sequence * 2654435761u) >> (32 - HashBits);
+    const int32_t candidate = table[hash];
+    table[hash] = (int32_t)i;
+
+    if (candidate < 0 || i - candidate > 0xffff || Read32(in + candidate) != sequence)
+    {
+      i++;
+      continue;
+    }
+
+    size_t length = MinMatch;
+    while (i + length < size && in[candidate + length] == in[i + length])
+      length++;
+
+    emit(anchor, i - anchor, i - candidate, length);
+    i += length;
+    anchor = i;
+  }
+
+  emit(anchor, size - anchor, 0, 0);
+}
+
+static bool ReadLength(const uint8_t *&data, const uint8_t *end, size_t &length)
+{
+  uint8_t byte;
+  do
+  {
+    if (data >= end)
+      return false;
+    byte = *data++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+static bool DecompressLZ(const uint8_t *data, const uint8_t *end, std::vector<uint8_t> &out, size_t size)
+{
+  out.resize(size);
+  uint8_t *dst = out.data();
+  size_t o = 0;
+
+  while (data < end)
+  {
+    const uint8_t token = *data++;
+
+    size_t literalLength = token >> 4;
+    if (literalLength == 15 && !ReadLength(data, end, literalLength))
+      return false;
+    if (literalLength > (size_t)(end - data) || literalLength > size - o)
+      return false;
+    std::copy(data, data + literalLength, dst + o);
+    data += literalLength;
+    o += literalLength;
+
+    if (data == end)
+      break;
+
+    if (end - data < 2)
+      return false;
+    const size_t offset = data[0] | (data[1] << 8);
+    data += 2;
+
+    size_t matchLength = (token & 15) + 4;
+    if ((token & 15) == 15 && !ReadLength(data, end, matchLength))
+      return false;
+    if (offset == 0 || offset > o || matchLength > size - o)
+      return false;
+
+    // matches may overlap what they are copying, run lengths of one byte repeat it
+    const uint8_t *src = dst + o - offset;
+    if (offset >= matchLength)
+      std::copy(src, src + matchLength, dst + o);
+    else
+      for (size_t k = 0; k < matchLength; k++)
+        dst[o + k] = src[k];
+    o += matchLength;
+  }
+
+  return o == size;
+}
+
+void EncodeVoxels(const std::vector<Voxel> &voxels, std::vector<uint8_t> &out)
+{
+  EncodeVoxels(voxels.data(), voxels.size(), out);
+}
+
+void EncodeVoxels(const Voxel *voxels, size_t count, std::vector<uint8_t> &out)
+{
+  std::vector<uint8_t> runs;
+  EncodeRuns(voxels, count, runs);
+
+  std::vector<uint8_t> compressed;
+  WriteVarint(compressed, runs.size());
+  CompressLZ(runs.data(), runs.size(), compressed);
+
+  // surface chunks repeat the same run patterns row after row, all air or stone chunks are a few bytes either way
+  out.clear();
+  if (compressed.size() < runs.size())
+  {
+    out.push_back(CodecLZ);
+    out.insert(out.end(), compressed.begin(), compressed.end());
+  }
+  else
+  {
+    out.push_back(0);
+    out.insert(out.end(), runs.begin(), runs.end());
+  }
+}
+
+bool DecodeVoxels(const uint8_t *data, size_t size, std::vector<Voxel> &voxels)
+{
+  const uint8_t *end = data + size;
+  if (data == end)
+    return false;
+
+  const uint8_t flags = *data++;
+  if (!(flags & CodecLZ))
+    return DecodeRuns(data, end, voxels);
+
+  uint64_t runsSize;
+  if (!ReadVarint(data, end, runsSize) || runsSize > MaxVoxels * 8)
+    return false;
+
+  std::vector<uint8_t> runs;
+  if (!DecompressLZ(data, end, runs, runsSize))
+    return false;
+
+  return DecodeRuns(runs.data(), runs.data() + runs.size(), voxels);
+}
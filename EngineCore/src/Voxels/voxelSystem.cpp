@@ -1,77 +1,310 @@
 #include <random>
+#include <algorithm>
+#include <cstdlib>
 
 #include "voxelSystem.hpp"
-#include "voxelMesh.hpp"
+#include "profiler.hpp"
 
 void VoxelSystem::Init(std::shared_ptr<Coordinator> coordinator)
 {
   gCoordinator = coordinator;
 }
 
-void VoxelSystem::Update(float deltaTime, const glm::vec3 &playerPos)
+// Calls fn for every coordinate inside [aMin, aMax] that is outside [bMin, bMax]. Only the rows that
+// cross the overlap are walked, so two boxes a chunk apart cost the shell between them, not the cube.
+template <typename Fn>
+static void ForEachInBoxDifference(const glm::ivec3 &aMin, const glm::ivec3 &aMax, const glm::ivec3 &bMin, const glm::ivec3 &bMax, const Fn &fn)
 {
-  const glm::ivec3 playerChunk = WorldToChunk(playerPos);
+  const glm::ivec3 overlapMin = glm::max(aMin, bMin);
+  const glm::ivec3 overlapMax = glm::min(aMax, bMax);
+  const bool overlaps = overlapMin.x <= overlapMax.x && overlapMin.y <= overlapMax.y && overlapMin.z <= overlapMax.z;
 
-  // lod 0
-  for (int x = -world.renderRadius0.x; x <= world.renderRadius0.x; ++x)
-    for (int y = -world.renderRadius0.y; y <= world.renderRadius0.y; ++y)
-      for (int z = -world.renderRadius0.z; z <= world.renderRadius0.z; ++z)
+  for (int x = aMin.x; x <= aMax.x; ++x)
+    for (int y = aMin.y; y <= aMax.y; ++y)
+    {
+      if (overlaps && x >= overlapMin.x && x <= overlapMax.x && y >= overlapMin.y && y <= overlapMax.y)
       {
-        glm::ivec3 coord = playerChunk + glm::ivec3(x, y, z);
-
-        if (!ChunkExists(coord))
-          CreateChunk(coord, 0);
+        for (int z = aMin.z; z < overlapMin.z; ++z)
+          fn(glm::ivec3(x, y, z));
+        for (int z = overlapMax.z + 1; z <= aMax.z; ++z)
+          fn(glm::ivec3(x, y, z));
+        continue;
       }
 
-  // lod 1
-  for (int x = -world.renderRadius1.x; x <= world.renderRadius1.x; ++x)
-    for (int y = -world.renderRadius1.y; y <= world.renderRadius1.y; ++y)
-      for (int z = -world.renderRadius1.z; z <= world.renderRadius1.z; ++z)
-      {
-        glm::ivec3 coord = playerChunk + glm::ivec3(x, y, z);
+      for (int z = aMin.z; z <= aMax.z; ++z)
+        fn(glm::ivec3(x, y, z));
+    }
+}
 
-        if (!ChunkExists(coord))
-          CreateChunk(coord, 1);
-      }
+void VoxelSystem::Update(float deltaTime, const glm::vec3 &playerPos, const glm::vec3 &viewDirection)
+{
+  PROFILE_ZONE("VoxelSystem::Update");
+  stats = {};
+  const glm::ivec3 playerChunk = WorldToChunk(playerPos);
+  const glm::ivec3 loadRadius = LoadRadius();
+  const glm::ivec3 unloadRadius = UnloadRadius();
 
-  // lod 2
-  for (int x = -world.renderRadius2.x; x <= world.renderRadius2.x; ++x)
-    for (int y = -world.renderRadius2.y; y <= world.renderRadius2.y; ++y)
-      for (int z = -world.renderRadius2.z; z <= world.renderRadius2.z; ++z)
-      {
-        glm::ivec3 coord = playerChunk + glm::ivec3(x, y, z);
+  // the load set only changes when the player crosses a chunk boundary, every other frame just drains the queue
+  if (!hasQueuedAround || loadRadius != queuedLoadRadius || unloadRadius != queuedUnloadRadius)
+  {
+    UnloadDistantChunks(playerChunk);
+    UpdateAllChunkLODs(playerChunk);
+    QueueMissingChunks(playerChunk);
+    RescoreRequests(playerChunk, viewDirection);
+  }
+  else if (playerChunk != queuedAroundChunk)
+  {
+    UnloadLeavingChunks(queuedAroundChunk, playerChunk);
+    UpdateChunkLODsAround(queuedAroundChunk, playerChunk);
+    QueueEnteringChunks(queuedAroundChunk, playerChunk);
+    RescoreRequests(playerChunk, viewDirection);
+  }
+  queuedAroundChunk = playerChunk;
+  queuedLoadRadius = loadRadius;
+  queuedUnloadRadius = unloadRadius;
+  hasQueuedAround = true;
+
+  PROFILE_COUNTER("Loaded chunks", world.chunkMap.size());
+  PROFILE_COUNTER("Queued chunks", requestQueue.size());
+  if (requestQueue.empty())
+  {
+    // counters hold their last value in the trace, so idle frames report zero
+    PROFILE_COUNTER("Chunks created", stats.created);
+    PROFILE_COUNTER("Chunks generated", stats.generated);
+    return;
+  }
 
-        if (!ChunkExists(coord))
-          CreateChunk(coord, 2);
-      }
+  // closest chunks in front of the camera first, the rest wait for later updates
+  std::vector<Entity> newChunks;
+  std::vector<uint8_t> spawned;
+  while (!requestQueue.empty() && newChunks.size() < chunksPerUpdate)
+  {
+    std::pop_heap(requestQueue.begin(), requestQueue.end(), CompareRequests);
+    ChunkRequest request = requestQueue.back();
+    requestQueue.pop_back();
+    queuedChunks.erase(request.coord);
+
+    // a queued promotion regenerates the chunk that is already there
+    auto it = world.chunkMap.find(request.coord);
+    bool exists = it != world.chunkMap.end();
+    if (exists)
+      snapshotWriter.Release(request.coord, gCoordinator->GetComponent<ChunkComponent>(it->second).voxelData);
+    newChunks.push_back(exists ? it->second : SpawnChunk(request.coord, request.lod));
+    spawned.push_back(!exists);
+  }
+  stats.created = newChunks.size();
+  PROFILE_COUNTER("Chunks created", stats.created);
+
+  // chunks only write their own voxel data while generating, so the whole batch runs in parallel
+  std::vector<uint8_t> generated(newChunks.size(), 0);
+  gCoordinator->ParallelFor(newChunks.size(), 1, [&](size_t begin, size_t end)
+                            {
+                              for (size_t i = begin; i < end; i++)
+                              {
+                                PROFILE_ZONE("VoxelSystem::GenerateChunk");
+                                // promotions can still find a finer copy on disk
+                                if (!(spawned[i] && RestoreCachedVoxelData(newChunks[i])) && !LoadStoredVoxelData(newChunks[i]))
+                                {
+                                  GenerateVoxelData(newChunks[i]);
+                                  generated[i] = 1;
+                                }
+                                ApplyEdits(newChunks[i]);
+                              } });
+  stats.generated = std::count(generated.begin(), generated.end(), 1);
+  PROFILE_COUNTER("Chunks generated", stats.generated);
+
+  if (persistGeneratedChunks)
+  {
+    for (size_t i = 0; i < newChunks.size(); i++)
+    {
+      if (generated[i])
+        unsavedChunks.insert(gCoordinator->GetComponent<ChunkComponent>(newChunks[i]).worldPosition);
+    }
+  }
+}
 
-  // lod 3
-  for (int x = -world.renderRadius3.x; x <= world.renderRadius3.x; ++x)
-    for (int y = -world.renderRadius3.y; y <= world.renderRadius3.y; ++y)
-      for (int z = -world.renderRadius3.z; z <= world.renderRadius3.z; ++z)
-      {
-        glm::ivec3 coord = playerChunk + glm::ivec3(x, y, z);
+std::array<size_t, CHUNK_LOD_COUNT> VoxelSystem::LoadedChunksPerLOD() const
+{
+  std::array<size_t, CHUNK_LOD_COUNT> counts{};
+  for (const auto &[coord, entity] : world.chunkMap)
+  {
+    const int lod = gCoordinator->GetComponent<ChunkComponent>(entity).chunkLOD;
+    if (lod >= 0 && lod < CHUNK_LOD_COUNT)
+      counts[lod]++;
+  }
+  return counts;
+}
 
-        if (!ChunkExists(coord))
-          CreateChunk(coord, 3);
-      }
+size_t VoxelSystem::VoxelMemoryBytes() const
+{
+  size_t bytes = 0;
+  for (const auto &[coord, entity] : world.chunkMap)
+    bytes += gCoordinator->GetComponent<ChunkComponent>(entity).voxelData.capacity() * sizeof(Voxel);
+  return bytes;
+}
 
-  // lod 4
-  for (int x = -world.renderRadius4.x; x <= world.renderRadius4.x; ++x)
-    for (int y = -world.renderRadius4.y; y <= world.renderRadius4.y; ++y)
-      for (int z = -world.renderRadius4.z; z <= world.renderRadius4.z; ++z)
-      {
-        glm::ivec3 coord = playerChunk + glm::ivec3(x, y, z);
+glm::ivec3 VoxelSystem::LoadRadius() const
+{
+  return glm::max(glm::max(glm::max(world.renderRadius0, world.renderRadius1), glm::max(world.renderRadius2, world.renderRadius3)), world.renderRadius4);
+}
+
+glm::ivec3 VoxelSystem::UnloadRadius() const
+{
+  constexpr float padding = 1.25;
+  return glm::ivec3(glm::vec3(world.renderRadius4) * padding);
+}
+
+static bool InsideRadius(const glm::ivec3 &offset, const glm::ivec3 &radius)
+{
+  return std::abs(offset.x) <= radius.x && std::abs(offset.y) <= radius.y && std::abs(offset.z) <= radius.z;
+}
+
+glm::ivec3 VoxelSystem::RenderRadius(int lod) const
+{
+  const glm::ivec3 radii[CHUNK_LOD_COUNT] = {world.renderRadius0, world.renderRadius1, world.renderRadius2, world.renderRadius3, world.renderRadius4};
+  return radii[lod];
+}
+
+int VoxelSystem::DesiredLOD(const glm::ivec3 &offset) const
+{
+  for (int lod = 0; lod < CHUNK_LOD_COUNT; lod++)
+  {
+    if (InsideRadius(offset, RenderRadius(lod)))
+      return lod;
+  }
+  return -1;
+}
 
-        if (!ChunkExists(coord))
-          CreateChunk(coord, 4);
+int VoxelSystem::TargetLOD(const glm::ivec3 &offset, int currentLod) const
+{
+  // promote as soon as the chunk is inside a finer ring
+  int lod = DesiredLOD(offset);
+  if (lod >= 0 && lod < currentLod)
+    return lod;
+
+  // only demote once the chunk is lodHysteresis chunks past the ring it is in, so walking back and forth over a ring edge does not regenerate it
+  for (lod = currentLod; lod < CHUNK_LOD_COUNT; lod++)
+  {
+    if (InsideRadius(offset, RenderRadius(lod) + glm::ivec3(lodHysteresis)))
+      return lod;
+  }
+  return currentLod; // past every ring, it is about to be unloaded
+}
+
+void VoxelSystem::UpdateChunkLOD(const glm::ivec3 &playerChunk, const glm::ivec3 &coord)
+{
+  auto it = world.chunkMap.find(coord);
+  if (it == world.chunkMap.end())
+    return;
+
+  const int lod = gCoordinator->GetComponent<ChunkComponent>(it->second).chunkLOD;
+  SetChunkLOD(coord, TargetLOD(coord - playerChunk, lod));
+}
+
+void VoxelSystem::UpdateAllChunkLODs(const glm::ivec3 &playerChunk)
+{
+  std::vector<glm::ivec3> coords;
+  coords.reserve(world.chunkMap.size());
+  for (const auto &[chunkPos, entity] : world.chunkMap)
+    coords.push_back(chunkPos);
+
+  for (const glm::ivec3 &coord : coords)
+    UpdateChunkLOD(playerChunk, coord);
+}
+
+void VoxelSystem::UpdateChunkLODsAround(const glm::ivec3 &oldPlayerChunk, const glm::ivec3 &playerChunk)
+{
+  // a chunk's target only changes when it enters a ring or leaves a ring's hysteresis band, so only those shells are walked
+  for (int lod = 0; lod < CHUNK_LOD_COUNT - 1; lod++)
+  {
+    const glm::ivec3 radius = RenderRadius(lod);
+    const glm::ivec3 demoteRadius = radius + glm::ivec3(lodHysteresis);
+
+    ForEachInBoxDifference(playerChunk - radius, playerChunk + radius, oldPlayerChunk - radius, oldPlayerChunk + radius, [&](const glm::ivec3 &coord)
+                           { UpdateChunkLOD(playerChunk, coord); });
+    ForEachInBoxDifference(oldPlayerChunk - demoteRadius, oldPlayerChunk + demoteRadius, playerChunk - demoteRadius, playerChunk + demoteRadius, [&](const glm::ivec3 &coord)
+                           { UpdateChunkLOD(playerChunk, coord); });
+  }
+}
+
+void VoxelSystem::QueueMissingChunks(const glm::ivec3 &playerChunk)
+{
+  const glm::ivec3 radius = LoadRadius();
+
+  for (int x = -radius.x; x <= radius.x; ++x)
+    for (int y = -radius.y; y <= radius.y; ++y)
+      for (int z = -radius.z; z <= radius.z; ++z)
+        QueueChunk(playerChunk, playerChunk + glm::ivec3(x, y, z));
+}
+
+void VoxelSystem::QueueEnteringChunks(const glm::ivec3 &oldPlayerChunk, const glm::ivec3 &playerChunk)
+{
+  const glm::ivec3 radius = LoadRadius();
+  ForEachInBoxDifference(playerChunk - radius, playerChunk + radius, oldPlayerChunk - radius, oldPlayerChunk + radius, [&](const glm::ivec3 &coord)
+                         { QueueChunk(playerChunk, coord); });
+}
+
+void VoxelSystem::QueueChunk(const glm::ivec3 &playerChunk, const glm::ivec3 &coord)
+{
+  int lod = DesiredLOD(coord - playerChunk);
+  if (lod < 0 || ChunkExists(coord) || queuedChunks.count(coord))
+    return;
+
+  requestQueue.push_back({coord, lod, 0.0f});
+  queuedChunks.insert(coord);
+}
+
+void VoxelSystem::RescoreRequests(const glm::ivec3 &playerChunk, const glm::vec3 &viewDirection)
+{
+  const float viewLength = glm::length(viewDirection);
+  const glm::vec3 forward = viewLength > 0.0f ? viewDirection / viewLength : glm::vec3(0.0f);
+
+  size_t kept = 0;
+  for (size_t i = 0; i < requestQueue.size(); i++)
+  {
+    ChunkRequest request = requestQueue[i];
+    glm::ivec3 offset = request.coord - playerChunk;
+
+    // A loaded chunk already has its new lod but not the samples for it, so its request stays until it
+    // is regenerated or unloaded, however far the player moved. New chunks take whatever their ring is now.
+    auto it = world.chunkMap.find(request.coord);
+    if (it != world.chunkMap.end())
+    {
+      const auto &chunk = gCoordinator->GetComponent<ChunkComponent>(it->second);
+      const size_t resolution = chunk.Resolution();
+      if (chunk.voxelData.size() == resolution * resolution * resolution)
+      {
+        queuedChunks.erase(request.coord);
+        continue;
       }
+      request.lod = chunk.chunkLOD;
+    }
+    else
+    {
+      int lod = DesiredLOD(offset);
+      if (lod < 0)
+      {
+        queuedChunks.erase(request.coord);
+        continue;
+      }
+      request.lod = lod;
+    }
+
+    // chunks behind the camera count as up to twice as far away, coarser lods go after finer ones
+    float distance = glm::length(glm::vec3(offset));
+    float facing = distance > 0.0f ? glm::dot(glm::vec3(offset) / distance, forward) : 1.0f;
+    request.priority = distance * (1.5f - 0.5f * facing) + request.lod * lodPriorityBias;
+
+    requestQueue[kept++] = request;
+  }
+  requestQueue.resize(kept);
 
-  UnloadDistantChunks(playerChunk);
+  std::make_heap(requestQueue.begin(), requestQueue.end(), CompareRequests);
 }
 
 void VoxelSystem::UnloadDistantChunks(const glm::ivec3 &playerChunk)
 {
+  const glm::ivec3 radius = UnloadRadius();
 
   std::vector<glm::ivec3> chunksToRemove;
   chunksToRemove.reserve(world.chunkMap.size());
@@ -79,31 +312,53 @@ void VoxelSystem::UnloadDistantChunks(const glm::ivec3 &playerChunk)
   for (const auto &[chunkPos, entity] : world.chunkMap)
   {
     glm::ivec3 delta = chunkPos - playerChunk;
-    constexpr float padding = 1.25;
-    if (std::abs(delta.x) > world.renderRadius4.x * padding ||
-        std::abs(delta.y) > world.renderRadius4.y * padding ||
-        std::abs(delta.z) > world.renderRadius4.z * padding)
+    if (std::abs(delta.x) > radius.x ||
+        std::abs(delta.y) > radius.y ||
+        std::abs(delta.z) > radius.z)
     {
       chunksToRemove.push_back(chunkPos);
     }
   }
 
   for (const glm::ivec3 &chunkPos : chunksToRemove)
-  {
-    Entity e = world.chunkMap.at(chunkPos);
+    UnloadChunk(chunkPos);
+}
 
-    if (gCoordinator->HasComponent<MeshComponent>(e))
-    {
-      gCoordinator->GetComponent<MeshComponent>(e).mesh->Cleanup();
-    }
-    if (gCoordinator->HasComponent<VoxelMeshComponent>(e))
-    {
-      gCoordinator->GetComponent<VoxelMeshComponent>(e).mesh->Cleanup();
-    }
+void VoxelSystem::UnloadLeavingChunks(const glm::ivec3 &oldPlayerChunk, const glm::ivec3 &playerChunk)
+{
+  const glm::ivec3 radius = UnloadRadius();
+  ForEachInBoxDifference(oldPlayerChunk - radius, oldPlayerChunk + radius, playerChunk - radius, playerChunk + radius, [&](const glm::ivec3 &coord)
+                         {
+                           if (ChunkExists(coord))
+                             UnloadChunk(coord); });
+}
+
+void VoxelSystem::UnloadChunk(const glm::ivec3 &chunkPos)
+{
+  Entity e = world.chunkMap.at(chunkPos);
+  auto &chunk = gCoordinator->GetComponent<ChunkComponent>(e);
+  int lod = chunk.chunkLOD;
 
-    gCoordinator->DestroyEntity(e);
-    world.chunkMap.erase(chunkPos);
+  // data still waiting on a promotion is not at chunkLOD, it is not worth keeping
+  const size_t resolution = chunk.Resolution();
+  const bool current = chunk.voxelData.size() == resolution * resolution * resolution;
+  if (current)
+    chunkCache.Store(chunkPos, lod, chunk.voxelData);
+
+  // a save in progress takes the data over instead of it being freed, and writes it itself
+  const bool unsaved = unsavedChunks.erase(chunkPos) > 0;
+  if (!snapshotWriter.Release(chunkPos, chunk.voxelData) && unsaved && current)
+    SaveChunk(e);
+
+  {
+    std::lock_guard<std::mutex> lock(editMutex);
+    SaveEditsLocked(chunkPos);
   }
+
+  // dropping the mesh components frees the chunk's GPU buffers, the meshes clean up when destroyed
+  gCoordinator->DestroyEntity(e);
+  world.chunkMap.erase(chunkPos);
+  ChunkUnloaded(chunkPos, lod);
 }
 
 bool VoxelSystem::ChunkExists(const glm::ivec3 &coord)
@@ -117,6 +372,18 @@ bool VoxelSystem::ChunkExists(const glm::ivec3 &coord)
 }
 
 void VoxelSystem::CreateChunk(const glm::ivec3 &coord, int lod)
+{
+  Entity chunk = SpawnChunk(coord, lod);
+  if (!LoadStoredVoxelData(chunk))
+  {
+    GenerateVoxelData(chunk);
+    if (persistGeneratedChunks)
+      unsavedChunks.insert(coord);
+  }
+  ApplyEdits(chunk);
+}
+
+Entity VoxelSystem::SpawnChunk(const glm::ivec3 &coord, int lod)
 {
   Entity chunk = gCoordinator->CreateEntity();
 
@@ -129,14 +396,237 @@ void VoxelSystem::CreateChunk(const glm::ivec3 &coord, int lod)
   gCoordinator->AddComponent<ChunkComponent>(chunk, std::move(cc));
 
   world.chunkMap[coord] = chunk;
+  ChunkSpawned(coord, lod);
+
+  return chunk;
+}
+
+void VoxelSystem::SetChunkLOD(const glm::ivec3 &coord, int lod)
+{
+  auto it = world.chunkMap.find(coord);
+  if (it == world.chunkMap.end())
+    return;
+
+  Entity entity = it->second;
+  auto &chunk = gCoordinator->GetComponent<ChunkComponent>(entity);
+  const int oldLod = chunk.chunkLOD;
+  if (lod == oldLod)
+    return;
+
+  if (lod < oldLod)
+  {
+    chunk.chunkLOD = lod;
+    ChunkLODChanged(coord, oldLod, lod);
+    QueueRegeneration(coord, lod);
+    return;
+  }
+
+  const int oldResolution = chunk.Resolution();
+
+  chunk.chunkLOD = lod;
+
+  // data still waiting on a regeneration does not hold the old lod's samples yet, regenerate at the new lod instead
+  if (chunk.voxelData.size() != (size_t)oldResolution * oldResolution * oldResolution)
+  {
+    chunk.chunkState = ChunkState::NeedsMeshing;
+    ChunkLODChanged(coord, oldLod, lod);
+    QueueRegeneration(coord, lod);
+    return;
+  }
+
+  std::vector<Voxel> resampled = ResampleVoxels(chunk.voxelData, oldLod, lod);
+  snapshotWriter.Release(coord, chunk.voxelData);
+  chunk.voxelData = std::move(resampled);
+  chunk.chunkState = ChunkState::NeedsMeshing;
+  ChunkLODChanged(coord, oldLod, lod);
+}
+
+std::vector<Voxel> VoxelSystem::ResampleVoxels(const std::vector<Voxel> &voxels, int oldLod, int lod)
+{
+  // every coarser sample is also a sample of the finer lattice, so just pick them out
+  const int oldResolution = CHUNK_SIZE >> oldLod;
+  const int resolution = CHUNK_SIZE >> lod;
+  const int factor = 1 << (lod - oldLod);
+
+  std::vector<Voxel> resampled((size_t)resolution * resolution * resolution);
+  for (int y = 0; y < resolution; y++)
+    for (int z = 0; z < resolution; z++)
+      for (int x = 0; x < resolution; x++)
+        resampled[x + resolution * (z + resolution * y)] = voxels[x * factor + oldResolution * (z * factor + oldResolution * y * factor)];
+
+  return resampled;
+}
+
+bool VoxelSystem::RestoreCachedVoxelData(Entity chunk)
+{
+  auto &chunkComp = gCoordinator->GetComponent<ChunkComponent>(chunk);
+
+  int cachedLod;
+  if (!chunkCache.Take(chunkComp.worldPosition, chunkComp.chunkLOD, chunkComp.voxelData, cachedLod))
+    return false;
+
+  if (cachedLod != chunkComp.chunkLOD)
+    chunkComp.voxelData = ResampleVoxels(chunkComp.voxelData, cachedLod, chunkComp.chunkLOD);
+
+  chunkComp.voxelData.shrink_to_fit();
+  chunkComp.chunkState = ChunkState::NeedsMeshing;
+  return true;
+}
+
+bool VoxelSystem::LoadStoredVoxelData(Entity chunk)
+{
+  auto &chunkComp = gCoordinator->GetComponent<ChunkComponent>(chunk);
+  const glm::ivec3 &coord = chunkComp.worldPosition;
+
+  int storedLod;
+  if (!regionStorage.Read(coord.x, coord.y, coord.z, chunkComp.chunkLOD, chunkComp.voxelData, storedLod))
+    return false;
+
+  if (storedLod != chunkComp.chunkLOD)
+    chunkComp.voxelData = ResampleVoxels(chunkComp.voxelData, storedLod, chunkComp.chunkLOD);
+
+  chunkComp.voxelData.shrink_to_fit();
+  chunkComp.chunkState = ChunkState::NeedsMeshing;
+  return true;
+}
+
+void VoxelSystem::SaveChunk(Entity chunk)
+{
+  auto &chunkComp = gCoordinator->GetComponent<ChunkComponent>(chunk);
+  const glm::ivec3 &coord = chunkComp.worldPosition;
+  regionStorage.Write(coord.x, coord.y, coord.z, chunkComp.chunkLOD, chunkComp.voxelData);
+}
+
+bool VoxelSystem::OpenSave(const std::string &directory)
+{
+  WaitForSave();
+  unsavedChunks.clear();
+  {
+    std::lock_guard<std::mutex> lock(editMutex);
+    edits.clear();
+    unsavedEdits.clear();
+    if (!editLog.Open(directory + "/edits.log", edits))
+      return false;
+  }
+  return regionStorage.Open(directory + "/chunks");
+}
+
+void VoxelSystem::ApplyEdits(Entity chunk)
+{
+  auto &chunkComp = gCoordinator->GetComponent<ChunkComponent>(chunk);
+
+  std::lock_guard<std::mutex> lock(editMutex);
+  auto it = edits.find(chunkComp.worldPosition);
+  if (it != edits.end())
+    it->second.Apply(chunkComp.voxelData, chunkComp.chunkLOD);
+}
+
+void VoxelSystem::SaveEditsLocked(const glm::ivec3 &coord)
+{
+  if (!unsavedEdits.erase(coord))
+    return;
+
+  if (!editLog.Append(coord, edits.at(coord)))
+    unsavedEdits.insert(coord);
+}
+
+void VoxelSystem::SaveEdits()
+{
+  std::lock_guard<std::mutex> lock(editMutex);
+  std::vector<glm::ivec3> coords(unsavedEdits.begin(), unsavedEdits.end());
+  for (const glm::ivec3 &coord : coords)
+    SaveEditsLocked(coord);
+}
+
+bool VoxelSystem::SaveWorld()
+{
+  if (snapshotWriter.InProgress())
+    return false;
+
+  SaveEdits();
+
+  // only pointers to the live data are taken here, the copying happens on first write while the save runs
+  std::vector<SnapshotWriter::Chunk> chunks;
+  chunks.reserve(unsavedChunks.size());
+  for (auto it = unsavedChunks.begin(); it != unsavedChunks.end();)
+  {
+    const auto &chunk = gCoordinator->GetComponent<ChunkComponent>(world.chunkMap.at(*it));
+    const size_t resolution = chunk.Resolution();
+
+    // a promotion still in flight is saved once its data is generated
+    if (chunk.voxelData.size() != resolution * resolution * resolution)
+    {
+      ++it;
+      continue;
+    }
+
+    chunks.push_back({*it, chunk.chunkLOD, chunk.voxelData.data(), chunk.voxelData.size()});
+    it = unsavedChunks.erase(it);
+  }
+
+  if (chunks.empty())
+    return true;
+  return snapshotWriter.Start(regionStorage, std::move(chunks));
+}
 
-  GenerateVoxelData(chunk);
+void VoxelSystem::WaitForSave()
+{
+  snapshotWriter.Wait();
+}
+
+size_t VoxelSystem::PregenerateChunks(const std::vector<glm::ivec3> &coords)
+{
+  std::vector<Entity> chunks;
+  chunks.reserve(coords.size());
+  for (const glm::ivec3 &coord : coords)
+  {
+    if (!ChunkExists(coord) && !regionStorage.Contains(coord.x, coord.y, coord.z, 0))
+      chunks.push_back(SpawnChunk(coord, 0));
+  }
+
+  // encoding happens on the workers too, only appending to the region files is serialized
+  gCoordinator->ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+                            {
+                              for (size_t i = begin; i < end; i++)
+                              {
+                                GenerateVoxelData(chunks[i]);
+                                SaveChunk(chunks[i]);
+                              } });
+
+  for (Entity chunk : chunks)
+  {
+    const glm::ivec3 coord = gCoordinator->GetComponent<ChunkComponent>(chunk).worldPosition;
+    gCoordinator->DestroyEntity(chunk);
+    world.chunkMap.erase(coord);
+    ChunkUnloaded(coord, 0);
+  }
+  return chunks.size();
+}
+
+void VoxelSystem::QueueRegeneration(const glm::ivec3 &coord, int lod)
+{
+  for (ChunkRequest &request : requestQueue)
+  {
+    if (request.coord == coord)
+    {
+      request.lod = lod;
+      return;
+    }
+  }
+
+  // promotions are what the player is closest to, so they go ahead of everything queued
+  requestQueue.push_back({coord, lod, -1.0f});
+  std::push_heap(requestQueue.begin(), requestQueue.end(), CompareRequests);
+  queuedChunks.insert(coord);
 }
 
 ChunkComponent &VoxelSystem::StartGeneratingVoxelData(Entity chunk)
 {
   auto &chunkComp = gCoordinator->GetComponent<ChunkComponent>(chunk);
-  chunkComp.voxelData.resize(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+  const size_t resolution = chunkComp.Resolution();
+  chunkComp.voxelData.resize(resolution * resolution * resolution);
+  chunkComp.voxelData.shrink_to_fit();
+  chunkComp.chunkState = ChunkState::NeedsMeshing;
   return chunkComp;
 }
 
@@ -146,6 +636,14 @@ int VoxelSystem::getIndex(int x, int y, int z)
   return x + CHUNK_SIZE * z + CHUNK_SIZE * CHUNK_SIZE * flippedY;
 }
 
+int VoxelSystem::getIndex(int x, int y, int z, int lod)
+{
+  const int step = 1 << lod;
+  const int resolution = CHUNK_SIZE / step;
+  int flippedY = (CHUNK_SIZE - y - 1) / step;
+  return x / step + resolution * (z / step) + resolution * resolution * flippedY;
+}
+
 glm::ivec3 VoxelSystem::WorldToChunk(const glm::vec3 &pos) const
 {
   return {
@@ -179,6 +677,10 @@ Voxel &VoxelSystem::GetVoxel(const glm::ivec3 &worldPos)
 
   ChunkComponent &chunk = gCoordinator->GetComponent<ChunkComponent>(it->second);
 
+  // lod chunks only store every few voxels, there is nothing to edit in them, nor in chunks still waiting on a promotion
+  if (chunk.chunkLOD != 0 || chunk.voxelData.size() != (size_t)CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+    return AirVoxel();
+
   int index = local.x + CHUNK_SIZE * (local.z + CHUNK_SIZE * local.y);
 
   return chunk.voxelData[index];
@@ -187,7 +689,18 @@ Voxel &VoxelSystem::GetVoxel(const glm::ivec3 &worldPos)
 void VoxelSystem::SetVoxel(const glm::ivec3 &pos, uint32_t blockId)
 {
   Voxel &v = GetVoxel(pos);
+  if (&v == &AirVoxel())
+    return;
+
+  const glm::ivec3 chunkPos = WorldToChunk(pos);
+  ChunkComponent &chunk = gCoordinator->GetComponent<ChunkComponent>(world.chunkMap.at(chunkPos));
+  snapshotWriter.Preserve(chunkPos, chunk.voxelData);
   v.type = blockId;
+  {
+    std::lock_guard<std::mutex> lock(editMutex);
+    edits[chunkPos].Set((uint16_t)(&v - chunk.voxelData.data()), blockId);
+    unsavedEdits.insert(chunkPos);
+  }
 
   MarkChunkDirty(WorldToChunk(pos));
 
@@ -1,6 +1,9 @@
 #include "application.hpp"
 #include <chrono>
 #include <iostream>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
 #include "voxelMesh.hpp"
 
 const std::vector<Vertex> vertices = {
@@ -67,16 +70,17 @@ void processInput(GLFWwindow *window, float deltaTime, Camera &camera)
     camera.processKeyboard(DOWN, deltaTime);
 }
 
-Application::Application() : window(initWindow(windowWidth, windowHeight, "Voxel Game Engine", this)), renderer(window)
+Application::Application(bool headless) : window(headless ? nullptr : initWindow(windowWidth, windowHeight, "Voxel Game Engine", this)), renderer(window)
 {
-  if (!window)
+  if (!window && !headless)
   {
     std::cerr << "Failed to initialize window" << std::endl;
     exit(EXIT_FAILURE);
   }
+  renderer.offscreenExtent = {static_cast<uint32_t>(windowWidth), static_cast<uint32_t>(windowHeight)};
 }
 
-void Application::run()
+bool Application::run()
 {
   renderer.init();
 
@@ -92,6 +96,15 @@ void Application::run()
   coordinator->RegisterComponent<ChunkComponent>();
   coordinator->RegisterComponent<WorldComponent>();
 
+  // Register and configure transform system
+  transformSystem = coordinator->RegisterSystem<TransformSystem>();
+  {
+    Signature signature;
+    signature.set(coordinator->GetComponentType<TransformComponent>());
+    coordinator->SetSystemSignature<TransformSystem>(signature);
+  }
+  transformSystem->Init(coordinator);
+
   // Register and configure render system
   renderSystem = coordinator->RegisterSystem<RenderSystem>();
   {
@@ -99,15 +112,18 @@ void Application::run()
     signature.set(coordinator->GetComponentType<TransformComponent>());
     coordinator->SetSystemSignature<RenderSystem>(signature);
   }
-  renderSystem->Init(coordinator, windowWidth, windowHeight);
+  renderSystem->Init(coordinator, transformSystem, windowWidth, windowHeight);
+
+  if (window) // the overlay needs the window's input
+    performanceOverlay.Init(renderer, window);
+  renderSystem->drawOverlay = [this](VkCommandBuffer commandBuffer)
+  { performanceOverlay.Record(commandBuffer); };
 
   // Create a world entity
   Entity world = coordinator->CreateEntity();
   {
     WorldComponent worldComponent{};
-    worldComponent.minTerrainHeight = 32;
-    worldComponent.maxTerrainHeight = 128;
-    worldComponent.waterLevel = 48;
+    ConfigureDefaultTerrain(worldComponent);
     worldComponent.renderRadius0 = {4, 4, 4};
     worldComponent.renderRadius1 = {4, 4, 4};
     worldComponent.renderRadius2 = {4, 4, 4};
@@ -126,6 +142,7 @@ void Application::run()
     coordinator->SetSystemSignature<DefaultVoxelSystem>(signature);
   }
   voxelSystem->Init(coordinator);
+  voxelSystem->OpenSave("Saves/world_" + std::to_string(worldComp.seed));
 
   meshingSystem = coordinator->RegisterSystem<MeshingSystem>(worldComp);
   {
@@ -135,20 +152,39 @@ void Application::run()
   }
   meshingSystem->Init(coordinator);
 
-  auto addBlock = [&](const std::string &name, int top, int bottom, int side, int visible = true) -> uint32_t
+  // Declare component access so the scheduler knows which systems may overlap
   {
-    uint32_t id = worldComp.registry.blocks.size();
-    BlockType block;
-    block.name = name;
-    block.visible = visible;
-    block.textureTop = top;
-    block.textureBottom = bottom;
-    block.textureSide = side;
-
-    worldComp.registry.blocks.push_back(block);
-    worldComp.registry.nameToId[name] = id;
-    return id;
-  };
+    Signature reads;
+    Signature writes;
+    reads.set(coordinator->GetComponentType<WorldComponent>());
+    writes.set(coordinator->GetComponentType<ChunkComponent>());
+    writes.set(coordinator->GetComponentType<MeshComponent>());
+    writes.set(coordinator->GetComponentType<VoxelMeshComponent>());
+    coordinator->SetSystemAccess<DefaultVoxelSystem>(reads, writes);
+  }
+  {
+    Signature reads;
+    Signature writes;
+    reads.set(coordinator->GetComponentType<WorldComponent>());
+    writes.set(coordinator->GetComponentType<ChunkComponent>());
+    writes.set(coordinator->GetComponentType<TransformComponent>());
+    writes.set(coordinator->GetComponentType<VoxelMeshComponent>());
+    coordinator->SetSystemAccess<MeshingSystem>(reads, writes);
+  }
+  {
+    Signature reads;
+    reads.set(coordinator->GetComponentType<TransformComponent>());
+    reads.set(coordinator->GetComponentType<MeshComponent>());
+    reads.set(coordinator->GetComponentType<VoxelMeshComponent>());
+    reads.set(coordinator->GetComponentType<ChunkComponent>());
+    reads.set(coordinator->GetComponentType<Parent>());
+    coordinator->SetSystemAccess<RenderSystem>(reads, Signature{});
+  }
+
+  unsigned int threadCount = workerThreads;
+  if (workerThreads < 0)
+    threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+  coordinator->SetThreadCount(threadCount);
 
   std::vector<std::string> filePaths;
   filePaths.resize(11);
@@ -164,27 +200,7 @@ void Application::run()
   filePaths[9] = "Assets/textures/Tiles/snow.png";
   filePaths[10] = "Assets/textures/Tiles/water.png";
 
-  uint32_t air = addBlock("Air", -1, -1, -1, false);
-  uint32_t grass = addBlock("Grass", 2, 0, 1);
-  uint32_t dirt = addBlock("Dirt", 0, 0, 0);
-  uint32_t water = addBlock("Water", 10, 10, 10);
-  uint32_t stone = addBlock("Stone", 3, 3, 3);
-  uint32_t sand = addBlock("Sand", 4, 4, 4);
-  uint32_t logs = addBlock("Oak Log", 6, 6, 5);
-  uint32_t leaves = addBlock("Oak Leaves", 7, 7, 7);
-  uint32_t redSand = addBlock("Red Sand", 8, 8, 8);
-  uint32_t snow = addBlock("Snow", 9, 9, 9);
-
-  Biome plains;
-  plains.airBlock = air;
-  plains.waterBlock = water;
-  plains.topBlock = grass;
-  plains.topDepth = 1;
-  plains.fillerBlock = dirt;
-  plains.fillerDepth = 3;
-  plains.stoneBlock = stone;
-  plains.bottomBlock = stone;
-  voxelSystem->addBiome(plains, "Plains");
+  AddDefaultBlocksAndBiomes(worldComp, *voxelSystem);
 
   Texture skyTex = renderer.createTexutre("Sky", "Assets/textures/sky.png");
   Texture wood = renderer.createTexutre("Wood", "Assets/textures/wood.png");
@@ -223,50 +239,196 @@ void Application::run()
     LoadModel(vase, coordinator, renderer, wood, "Assets/models/smooth_vase.obj");
   }
 
-  mainLoop();
+  bool completed = mainLoop();
 
   cleanup();
+  return completed;
 }
 
-void Application::mainLoop()
+bool Application::mainLoop()
 {
-  float lastTime = glfwGetTime();
-  float fpsTimer = 0.0f;
-  int frameCount = 0;
+  auto lastTime = std::chrono::steady_clock::now(); // GLFW's clock needs GLFW, which headless runs never initialize
+  float statsTimer = 0.0f;
+
+  const float autosaveInterval = 120.0f;
+  float autosaveTimer = 0.0f;
 
-  while (!glfwWindowShouldClose(window))
+  bool profileKeyWasDown = false;
+  bool overlayKeyWasDown = false;
+  FrameStageTimes stageTimes;
+  Profiler::SetThreadName("Main");
+
+  CameraPathRecorder recorder;
+  CameraPath replay;
+  std::string replayName = replayCameraPath;
+  if (!replayCameraPath.empty())
+  {
+    // without a path nothing would end the run, a benchmark must not quietly turn into a free flight
+    if (!replay.Load(replayCameraPath) || replay.frames.empty())
+    {
+      std::cerr << "Failed to replay camera path! File: " << replayCameraPath << std::endl;
+      return false;
+    }
+  }
+  else if (flyDistance > 0.0f)
   {
-    float currentTime = glfwGetTime();
-    float dt = currentTime - lastTime;
-    lastTime = currentTime;
+    replay = CameraPath::Line(camera.Position, camera.Position + glm::vec3(flyDistance, 0.0f, 0.0f), flySpeed);
+    replayName = "line of " + std::to_string((int)flyDistance) + " blocks";
+  }
+  bool replaying = !replay.frames.empty();
+  size_t replayFrame = 0;
+  ReplayReport replayReport;
 
-    fpsTimer += dt;
-    frameCount++;
+  bool capturing = !window && !captureDirectory.empty() && captureEvery > 0;
+  if (capturing)
+    std::filesystem::create_directories(captureDirectory);
+  size_t frameIndex = 0;
+  bool running = true;
+
+  // nothing else closes a headless run without a replay
+  if (!window && !replaying && frameLimit == 0)
+    frameLimit = HeadlessFrameLimit;
+
+  // the average fps hides streaming hitches, so report the frame time distribution and trace the spikes
+  StutterDetector stutterDetector;
+  stutterDetector.Start();
+
+  while (running && !(window && glfwWindowShouldClose(window)))
+  {
+    stutterDetector.FrameBoundary();
+    const auto frameStart = std::chrono::steady_clock::now();
+    float frameTime = std::chrono::duration<float>(frameStart - lastTime).count();
+    lastTime = frameStart;
+    performanceOverlay.AddFrameTime(frameTime * 1000.0f);
+
+    // a replay runs the game at the path's timestep however long frames really take
+    float dt = replaying ? replay.timestep : frameTime;
+    if (replaying)
+    {
+      const CameraPathFrame &frame = replay.frames[replayFrame];
+      camera.Position = frame.position;
+      camera.setOrientation(frame.yaw, frame.pitch);
+    }
 
-    if (fpsTimer >= 1.0f) // every second
+    statsTimer += frameTime;
+    if (statsTimer >= 1.0f) // every second
     {
-      float fps = frameCount / fpsTimer;
-      printf("FPS: %.2f\n", fps);
+      FrameTimeHistogram &frameTimes = stutterDetector.Histogram();
+      printf("FPS: %.2f  frame ms p50 %.2f  p95 %.2f  p99 %.2f  max %.2f  stutters %llu\n", frameTimes.Count() / statsTimer,
+             frameTimes.Percentile(0.50), frameTimes.Percentile(0.95), frameTimes.Percentile(0.99), frameTimes.Max(),
+             (unsigned long long)stutterDetector.Stutters());
 
-      fpsTimer = 0.0f;
-      frameCount = 0;
+      frameTimes.Reset();
+      statsTimer = 0.0f;
     }
 
-    glfwPollEvents();
-    processInput(window, dt, camera);
+    // the chunks are written on a background thread, frames keep going while it runs
+    autosaveTimer += dt;
+    if (autosaveTimer >= autosaveInterval && voxelSystem->SaveWorld())
+      autosaveTimer = 0.0f;
+
+    if (window) // headless runs have no input
+    {
+      {
+        StageTimer timer(stageTimes.input);
+        glfwPollEvents();
+        if (replaying && glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+          glfwSetWindowShouldClose(window, GLFW_TRUE);
+        else if (!replaying && !performanceOverlay.WantsKeyboard())
+          processInput(window, dt, camera);
+      }
+
+      // F2 shows the performance overlay and frees the cursor to use it, the camera stops turning meanwhile
+      bool overlayKeyDown = glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS;
+      if (overlayKeyDown && !overlayKeyWasDown)
+      {
+        performanceOverlay.visible = !performanceOverlay.visible;
+        glfwSetInputMode(window, GLFW_CURSOR, performanceOverlay.visible ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+        firstMouse = true;
+      }
+      overlayKeyWasDown = overlayKeyDown;
+
+      // F3 writes the most recent frames the profiler still has as a Chrome trace
+      bool profileKeyDown = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+      if (profileKeyDown && !profileKeyWasDown && stutterDetector.WriteRecent("profile.json"))
+        std::cout << "Profiler capture written to profile.json" << std::endl;
+      profileKeyWasDown = profileKeyDown;
+    }
 
     auto &transform = coordinator->GetComponent<TransformComponent>(skybox);
     transform.translation = camera.Position;
 
-    voxelSystem->Update(dt, glm::vec3(camera.Position.x, -camera.Position.y, camera.Position.z));
-    meshingSystem->Update(renderer.getTexture("Voxel Textures"), renderer);
-    renderSystem->Update(renderer, dt, camera);
+    Texture voxelTextures = renderer.getTexture("Voxel Textures");
+    coordinator->ScheduleSystem<DefaultVoxelSystem>([&]
+                                                    {
+                                                      StageTimer timer(stageTimes.voxels);
+                                                      voxelSystem->Update(dt, glm::vec3(camera.Position.x, -camera.Position.y, camera.Position.z), glm::vec3(camera.Front.x, -camera.Front.y, camera.Front.z)); });
+    coordinator->ScheduleSystem<MeshingSystem>([&]
+                                               {
+                                                 StageTimer timer(stageTimes.meshing);
+                                                 meshingSystem->Update(voxelTextures, renderer); });
+    {
+      PROFILE_ZONE("Coordinator::RunSystems");
+      coordinator->RunSystems();
+    }
+
+    // after the flush so transforms added this frame already have a world matrix
+    {
+      StageTimer timer(stageTimes.transforms);
+      transformSystem->Update();
+    }
+
+    // shows the previous frame's render time, this frame's is measured while the overlay is recorded
+    performanceOverlay.Build(renderer, *voxelSystem, *meshingSystem, *renderSystem, stageTimes);
+
+    if (capturing && frameIndex % captureEvery == 0)
+    {
+      char name[32];
+      snprintf(name, sizeof(name), "frame_%06zu.png", frameIndex);
+      renderer.captureFrame((std::filesystem::path(captureDirectory) / name).string());
+    }
+
+    // rendering stays on the main thread since swapchain recreation talks to GLFW
+    {
+      StageTimer timer(stageTimes.render);
+      renderSystem->Update(renderer, dt, camera);
+    }
+
+    if (!recordCameraPath.empty())
+      recorder.Record(camera, frameTime);
+
+    if (replaying)
+    {
+      const float frameMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+      replayReport.Add({frameMs, stageTimes, voxelSystem->world.chunkMap.size(), voxelSystem->QueuedChunkCount(),
+                        voxelSystem->stats.created, voxelSystem->stats.generated, meshingSystem->stats.meshed,
+                        meshingSystem->stats.uploaded, meshingSystem->stats.uploadedBytes});
+
+      if (++replayFrame == replay.frames.size())
+      {
+        replayReport.Write(replayReportPath, replayName);
+        replaying = false;
+        running = false;
+      }
+    }
+
+    if (++frameIndex == frameLimit)
+    {
+      if (replaying) // cut short, report what ran
+        replayReport.Write(replayReportPath, replayName);
+      running = false;
+    }
   }
+
+  if (!recordCameraPath.empty() && recorder.Path().Save(recordCameraPath))
+    std::cout << "Camera path of " << recorder.Path().frames.size() << " frames written to " << recordCameraPath << std::endl;
+  return true;
 }
 
 void Application::cleanup()
 {
   vkDeviceWaitIdle(renderer.device);
+  performanceOverlay.Cleanup();
 
   for (auto &entity : renderSystem->mEntities)
   {
@@ -283,10 +445,16 @@ void Application::cleanup()
     }
   }
 
+  voxelSystem->WaitForSave();
+  voxelSystem->SaveWorld();
+  voxelSystem->WaitForSave();
+
   renderSystem.reset();
+  transformSystem.reset();
   coordinator.reset();
 
   renderer.cleanup();
 
-  closeWindow(window);
+  if (window)
+    closeWindow(window);
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "defaultWorld.hpp"
+
+void ConfigureDefaultTerrain(WorldComponent &world)
+{
+  world.minTerrainHeight = 32;
+  world.maxTerrainHeight = 128;
+  world.waterLevel = 48;
+}
+
+void AddDefaultBlocksAndBiomes(WorldComponent &world, DefaultVoxelSystem &voxelSystem)
+{
+  // texture indices are layers of the "Voxel Textures" array the application loads
+  auto addBlock = [&](const std::string &name, int top, int bottom, int side, int visible = true) -> uint32_t
+  {
+    uint32_t id = world.registry.blocks.size();
+    BlockType block;
+    block.name = name;
+    block.visible = visible;
+    block.textureTop = top;
+    block.textureBottom = bottom;
+    block.textureSide = side;
+
+    world.registry.blocks.push_back(block);
+    world.registry.nameToId[name] = id;
+    return id;
+  };
+
+  uint32_t air = addBlock("Air", -1, -1, -1, false);
+  uint32_t grass = addBlock("Grass", 2, 0, 1);
+  uint32_t dirt = addBlock("Dirt", 0, 0, 0);
+  uint32_t water = addBlock("Water", 10, 10, 10);
+  uint32_t stone = addBlock("Stone", 3, 3, 3);
+  uint32_t sand = addBlock("Sand", 4, 4, 4);
+  uint32_t logs = addBlock("Oak Log", 6, 6, 5);
+  uint32_t leaves = addBlock("Oak Leaves", 7, 7, 7);
+  uint32_t redSand = addBlock("Red Sand", 8, 8, 8);
+  uint32_t snow = addBlock("Snow", 9, 9, 9);
+
+  Biome plains;
+  plains.airBlock = air;
+  plains.waterBlock = water;
+  plains.topBlock = grass;
+  plains.topDepth = 1;
+  plains.fillerBlock = dirt;
+  plains.fillerDepth = 3;
+  plains.stoneBlock = stone;
+  plains.bottomBlock = stone;
+  voxelSystem.addBiome(plains, "Plains");
+}
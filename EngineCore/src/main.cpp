@@ -13,17 +13,81 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 
 #include "application.hpp"
 
-int main()
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Usage: GameEngine [--record camera.path] [--replay camera.path | --fly blocks [--fly-speed blocks_per_second]] [--replay-out replay.json]
+//                   [--headless [--frames count] [--capture-dir directory [--capture-every frames]]]
+// --record writes the flight to a camera path when the window closes. --replay and --fly drive the
+// camera at a fixed timestep instead, write per frame timings to --replay-out and exit at the end, or
+// exit with an error right away when the camera path does not load.
+// --headless renders offscreen without a window, on a software driver too (for lavapipe, point
+// VK_DRIVER_FILES at its ICD json). Without a replay it renders --frames frames (600 by default) of a still camera.
+// --capture-dir writes every --capture-every-th frame as a PNG, captured frames are slower than the rest.
+
+static const char *Argument(int argc, char **argv, const char *name)
+{
+  for (int i = 1; i + 1 < argc; i++)
+  {
+    if (std::strcmp(argv[i], name) == 0)
+      return argv[i + 1];
+  }
+  return nullptr;
+}
+
+static bool Flag(int argc, char **argv, const char *name)
 {
+  for (int i = 1; i < argc; i++)
   {
-    Application engine;
-    engine.run();
+    if (std::strcmp(argv[i], name) == 0)
+      return true;
   }
+  return false;
+}
 
-  std::cout << "Press Enter to exit" << std::endl;
-  std::cin.get();
-  return 0;
+int main(int argc, char **argv)
+{
+  bool benchmark = false;
+  int exitCode = EXIT_SUCCESS;
+  {
+    const bool headless = Flag(argc, argv, "--headless");
+    Application engine(headless);
+    if (const char *path = Argument(argc, argv, "--record"))
+      engine.recordCameraPath = path;
+    if (const char *path = Argument(argc, argv, "--replay"))
+      engine.replayCameraPath = path;
+    if (const char *distance = Argument(argc, argv, "--fly"))
+      engine.flyDistance = (float)std::atof(distance);
+    if (const char *speed = Argument(argc, argv, "--fly-speed"))
+      engine.flySpeed = std::max(1.0f, (float)std::atof(speed));
+    if (const char *path = Argument(argc, argv, "--replay-out"))
+      engine.replayReportPath = path;
+    if (const char *frames = Argument(argc, argv, "--frames"))
+      engine.frameLimit = (size_t)std::max(0, std::atoi(frames));
+    if (const char *directory = Argument(argc, argv, "--capture-dir"))
+    {
+      engine.captureDirectory = directory;
+      engine.captureEvery = 60;
+    }
+    if (const char *every = Argument(argc, argv, "--capture-every"))
+      engine.captureEvery = std::max(1, std::atoi(every));
+
+    benchmark = headless || !engine.replayCameraPath.empty() || engine.flyDistance > 0.0f;
+    if (!engine.run())
+      exitCode = EXIT_FAILURE;
+  }
+
+  // replays run unattended
+  if (!benchmark)
+  {
+    std::cout << "Press Enter to exit" << std::endl;
+    std::cin.get();
+  }
+  return exitCode;
 }
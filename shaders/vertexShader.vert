@@ -5,9 +5,9 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
   mat4 proj;
 } ubo;
 
-layout(push_constant) uniform PushConstants {
-  mat4 model;
-} pc;
+layout(set = 2, binding = 0) readonly buffer InstanceBuffer {
+  mat4 models[];
+} instances;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -17,7 +17,7 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-  gl_Position = ubo.proj * ubo.view * pc.model * vec4(inPosition, 1.0);
+  gl_Position = ubo.proj * ubo.view * instances.models[gl_InstanceIndex] * vec4(inPosition, 1.0);
   fragColor = inColor;
   fragTexCoord = inTexCoord;
 }
\ No newline at end of file